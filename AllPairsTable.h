@@ -0,0 +1,215 @@
+//
+//  AllPairsTable.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef AllPairsTable_h
+#define AllPairsTable_h
+
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <algorithm>
+
+#include "MappedFile.h"
+#include "WeightedGraph.h"
+
+// On-disk layout of a precomputed all-pairs table:
+//   AllPairsHeader
+//   double distance[vertexCount * vertexCount]  (row i holds the distances from i, DBL_MAX if unreachable)
+//   int32_t nextHop[vertexCount * vertexCount]  (first vertex after i on the path to j, -1 if unreachable)
+struct AllPairsHeader {
+    char magic[8];             // "EVAPSP1" followed by a zero byte
+    uint32_t vertexCount;      // Number of vertices in the graph
+    uint32_t reserved;         // Keeps the checksum 8-byte aligned
+    uint64_t weightsChecksum;  // FNV-1a checksum of the weights file the table was built from
+};
+
+// Class definition for AllPairsTable, precomputed distances and next hops between every
+// pair of vertices. The table is built offline and memory-mapped at startup, so distance
+// lookups are O(1) and paths unroll in O(path length) with no search at query time
+class AllPairsTable {
+private:
+    MappedFile file;         // Mapping of the table file
+    int vertexCount;         // Number of vertices (0 when no table is open)
+    const double* distances; // Start of the distance block inside the mapping
+    const int32_t* nextHops; // Start of the next-hop block inside the mapping
+
+    static constexpr const char* magicString = "EVAPSP1";
+
+    // Size in bytes of a table file for the given number of vertices
+    static size_t fileSize(int vertices) {
+        size_t cells = (size_t)vertices * vertices;
+        return sizeof(AllPairsHeader) + cells * sizeof(double) + cells * sizeof(int32_t);
+    }
+
+public:
+    AllPairsTable() : vertexCount(0), distances(nullptr), nextHops(nullptr) {}
+
+    // Run one search per source on the graph's worker pool (threads > 0 resizes the pool)
+    // and write the table to tableFileName. Returns false if the file cannot be written
+    static bool build(WeightedGraphType& graph, uint64_t weightsChecksum, const char* tableFileName, int threads = 0);
+
+    // Map a table file. Returns false if it is missing, truncated, built for a different
+    // number of vertices, or built from a different weights file (stale)
+    bool open(const char* tableFileName, int vertices, uint64_t weightsChecksum);
+
+    // Release the mapping
+    void close() {
+        file.close();
+        vertexCount = 0;
+        distances = nullptr;
+        nextHops = nullptr;
+    }
+
+    bool isOpen() const {
+        return vertexCount > 0;
+    }
+
+    // Get the smallest weight from i to j (DBL_MAX if unreachable)
+    double distance(int i, int j) const {
+        return distances[(size_t)i * vertexCount + j];
+    }
+
+    // Get the distances from i to every vertex
+    const double* distancesFrom(int i) const {
+        return distances + (size_t)i * vertexCount;
+    }
+
+    // Get the first vertex after i on the shortest path to j (-1 if unreachable)
+    int nextHop(int i, int j) const {
+        return nextHops[(size_t)i * vertexCount + j];
+    }
+
+    // Get the path from i to j with i on top of the stack, in the same form as
+    // ShortestPathTree::pathTo (only j itself if it is unreachable)
+    stack<int> path(int i, int j) const {
+        vector<int> hops;
+        path(i, j, hops);
+
+        stack<int> pathStack;
+        for (int k = (int)hops.size() - 1; k >= 0; k--)
+            pathStack.push(hops[k]);
+        return pathStack;
+    }
+
+    // Same as above, writing the path i first into an existing vector (reusing its buffer)
+    void path(int i, int j, vector<int>& hops) const {
+        hops.assign(1, i);
+        if (i != j && nextHop(i, j) == -1)
+            hops.assign(1, j);
+
+        // Unroll the next hops until the destination is reached
+        while (hops.back() != j)
+            hops.push_back(nextHop(hops.back(), j));
+    }
+};
+
+
+// Function to build the all-pairs table
+// Each worker runs one search per source and writes its rows straight into the mapped output file, so the table is never held in memory twice.
+// The file is written under a temporary name and renamed when complete
+bool AllPairsTable::build(WeightedGraphType& graph, uint64_t weightsChecksum, const char* tableFileName, int threads) {
+    int vertices = graph.getNumberOfVertices();
+    string tempFileName = string(tableFileName) + ".tmp";
+
+    if (vertices == 0)
+        return false;
+
+    MappedFile output;
+    if (!output.create(tempFileName.c_str(), fileSize(vertices))) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+
+    // Fill in the header
+    AllPairsHeader header;
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, magicString);
+    header.vertexCount = vertices;
+    header.weightsChecksum = weightsChecksum;
+    memcpy(output.data(), &header, sizeof(header));
+
+    double* distanceBlock = (double*)(output.data() + sizeof(AllPairsHeader));
+    int32_t* nextHopBlock = (int32_t*)(distanceBlock + (size_t)vertices * vertices);
+
+    // Run every source through the graph's batch pool; each tree is turned into its
+    // rows on the worker that computed it
+    vector<int> sources(vertices);
+    for (int source = 0; source < vertices; source++)
+        sources[source] = source;
+
+    if (threads > 0)
+        graph.setWorkerThreads(threads);
+
+    graph.forEachShortestPathTree(sources, [&](int source, const ShortestPathTree& tree) {
+        double* distanceRow = distanceBlock + (size_t)source * vertices;
+        int32_t* nextHopRow = nextHopBlock + (size_t)source * vertices;
+
+        copy(tree.distance.begin(), tree.distance.end(), distanceRow);
+        fill(nextHopRow, nextHopRow + vertices, -2); // -2 marks "not worked out yet"
+        nextHopRow[source] = source;
+
+        // The next hop of j is the next hop of its predecessor, or j itself when the
+        // predecessor is the source. Walk up to a known vertex and fill in on the way back
+        for (int j = 0; j < vertices; j++) {
+            if (!tree.reachable(j)) {
+                nextHopRow[j] = -1;
+                continue;
+            }
+
+            int v = j;
+            while (nextHopRow[v] == -2 && tree.predecessor[v] != source)
+                v = tree.predecessor[v];
+            if (nextHopRow[v] == -2)
+                nextHopRow[v] = v;
+
+            // Second walk over the same chain to fill it in
+            for (int k = j; nextHopRow[k] == -2; k = tree.predecessor[k])
+                nextHopRow[k] = nextHopRow[v];
+        }
+    });
+
+    bool ok = output.flush();
+    output.close();
+
+    // Replace the old table in one step, so readers never see a half-written file
+    if (!ok || rename(tempFileName.c_str(), tableFileName) != 0) {
+        remove(tempFileName.c_str());
+        cout << "Cannot write all-pairs table: " << tableFileName << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Function to map a precomputed table and check it matches the current graph
+bool AllPairsTable::open(const char* tableFileName, int vertices, uint64_t weightsChecksum) {
+    close();
+
+    if (!file.openReadOnly(tableFileName))
+        return false;
+
+    AllPairsHeader header;
+    if (file.length() < sizeof(header)) {
+        file.close();
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+
+    // Reject tables of another format, another graph size, or another weights file
+    if (memcmp(header.magic, magicString, sizeof(header.magic)) != 0 || (int)header.vertexCount != vertices ||
+        header.weightsChecksum != weightsChecksum || file.length() != fileSize(vertices)) {
+        file.close();
+        return false;
+    }
+
+    vertexCount = vertices;
+    distances = (const double*)(file.data() + sizeof(AllPairsHeader));
+    nextHops = (const int32_t*)(distances + (size_t)vertices * vertices);
+    return true;
+}
+
+#endif /* AllPairsTable_h */
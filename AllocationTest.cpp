@@ -0,0 +1,140 @@
+//
+//  AllocationTest.cpp
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+//  Build: cmake -S . -B build && cmake --build build
+//  Run:   ctest --test-dir build (or ./build/AllocationTest)
+//
+//  Checks that every query writing into a caller's buffer makes no heap allocation once its
+//  per-thread buffers have grown, on a synthetic network. Exits with 1 if any query allocates
+//
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+#include "WeightedGraph.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "RoadNetworkGenerator.h"
+
+// Heap allocations made by the calling thread so far, counted by the replacement operator new below
+static thread_local long allocationCount = 0;
+
+// Not inlined either, so the compiler does not see the malloc and warn that the operator
+// delete below frees it
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount++;
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw bad_alloc();
+    return memory;
+}
+
+// Not inlined, so the compiler does not pair the free with a new it cannot see
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// Read the coordinates of every location from a locations file written by RoadNetworkGenerator
+void readCoordinates(const string& fileName, vector<double>& latitudes, vector<double>& longitudes) {
+    ifstream infile(fileName);
+    string line;
+    while (getline(infile, line)) {
+        size_t longitude = line.rfind(','), latitude = line.rfind(',', longitude - 1);
+        latitudes.push_back(stod(line.substr(latitude + 1, longitude - latitude - 1)));
+        longitudes.push_back(stod(line.substr(longitude + 1)));
+    }
+}
+
+int main() {
+    const string weightsFile = "AllocationTestWeights.txt", locationsFile = "AllocationTestLocations.txt";
+    RoadNetworkOptions options;
+    options.locations = 5000;
+    if (!RoadNetworkGenerator::write(options, weightsFile.c_str(), locationsFile.c_str()))
+        return 1;
+
+    WeightedGraphType graph(0, weightsFile.c_str(), EDGE_LIST);
+    WeightedGraphType located(0, weightsFile.c_str(), EDGE_LIST); // The same roads, searched with A*
+    vector<double> latitudes, longitudes;
+    readCoordinates(locationsFile, latitudes, longitudes);
+    remove(weightsFile.c_str());
+    remove(locationsFile.c_str());
+
+    int size = graph.getNumberOfVertices();
+    if (size != options.locations || !located.setCoordinates(latitudes, longitudes)) {
+        cout << "Cannot load the test network." << endl;
+        return 1;
+    }
+    if (!graph.useFixedPointWeights(10)) {
+        cout << "Cannot search the test network with fixed-point weights." << endl;
+        return 1;
+    }
+    ContractionHierarchy hierarchy(graph);
+    LandmarkIndex landmarks;
+    landmarks.build(graph, 8);
+    vector<bool> chargerInstalled(size);
+    for (int v = 0; v < size; v++)
+        chargerInstalled[v] = v % 7 == 0;
+
+    vector<int> path;
+    vector<pair<int, double>> found;
+    ShortestPathTree tree;
+    size_t checksum = 0; // Keeps the results alive
+
+    struct Check {
+        const char* name;
+        function<void(int, int)> query;
+    };
+    vector<Check> checks = {
+        {"Dijkstra", [&](int o, int d) { graph.shortestPath(o, d, path); checksum += path.size(); }},
+        {"A*", [&](int o, int d) { located.shortestPath(o, d, path); checksum += path.size(); }},
+        {"Bidirectional", [&](int o, int d) { graph.shortestPathBidirectional(o, d, path); checksum += path.size(); }},
+        {"Fixed-point Dial", [&](int o, int d) { graph.shortestPathFixed<DialQueue>(o, d, path); checksum += path.size(); }},
+        {"Fixed-point radix heap tree", [&](int o, int) { graph.shortestPathTreeFixed<RadixHeapQueue>(o, tree); checksum += tree.reachable(0); }},
+        {"Contraction hierarchy", [&](int o, int d) { hierarchy.shortestPath(o, d, path); checksum += path.size(); }},
+        {"Landmarks", [&](int o, int d) { landmarks.shortestPath(o, d, path); checksum += path.size(); }},
+        {"3 nearest targets", [&](int o, int) { graph.nearestTargets(o, chargerInstalled, 3, found); checksum += found.size(); }},
+        {"Adjacency span", [&](int o, int) {
+            for (int v : graph.getAdjancencyList(o))
+                checksum += v;
+        }},
+    };
+
+    // Warm every query up on the same trips first, so its buffers reach their final size
+    int queries = 500;
+    int failures = 0;
+    for (const Check& check : checks) {
+        for (int q = 0; q < queries; q++)
+            check.query((q * 7919) % size, (q * 104729 + 13) % size);
+
+        long before = allocationCount;
+        for (int q = 0; q < queries; q++)
+            check.query((q * 7919) % size, (q * 104729 + 13) % size);
+        long allocations = allocationCount - before;
+
+        failures += allocations != 0;
+        cout << left << setw(30) << check.name << right << setw(10) << allocations << " allocations"
+             << (allocations != 0 ? "  FAILED" : "") << endl;
+    }
+
+    if (checksum == 0) {
+        cout << "No results." << endl;
+        return 1;
+    }
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,509 @@
+//
+//  BatchMode.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef BatchMode_h
+#define BatchMode_h
+
+#include <cstdio>
+#include <cstring>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "EVCharging.h"
+
+using namespace std;
+
+// Output formats of the batch mode
+enum BatchFormat { BATCH_TSV, BATCH_JSON };
+
+// A query read by the batch mode, with its answer once it is solved
+struct BatchItem {
+    long number;         // Line number of the query in the input
+    Query query;         // The parsed query
+    string error;        // Why the line could not be parsed (empty if it was)
+    QueryResult result;  // The answer, filled in by the solver
+};
+
+// Class definition for BoundedQueue, a blocking first-in first-out queue holding at most
+// capacity items, used to hand work between the stages of the batch pipeline
+template <class Item>
+class BoundedQueue {
+private:
+    deque<Item> items;
+    size_t capacity;
+    bool closed;
+    mutex itemsMutex;
+    condition_variable notFull;
+    condition_variable notEmpty;
+
+public:
+    BoundedQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    // Add an item, waiting while the queue is full
+    void push(Item item) {
+        unique_lock<mutex> lock(itemsMutex);
+        notFull.wait(lock, [&]() { return items.size() < capacity; });
+        items.push_back(move(item));
+        notEmpty.notify_one();
+    }
+
+    // Take the oldest item, waiting while the queue is empty. Returns false once the queue
+    // is closed and drained
+    bool pop(Item& item) {
+        unique_lock<mutex> lock(itemsMutex);
+        notEmpty.wait(lock, [&]() { return !items.empty() || closed; });
+        if (items.empty())
+            return false;
+        item = move(items.front());
+        items.pop_front();
+        notFull.notify_one();
+        return true;
+    }
+
+    // Mark the end of the input; pop returns false after the last item
+    void close() {
+        lock_guard<mutex> lock(itemsMutex);
+        closed = true;
+        notEmpty.notify_all();
+    }
+};
+
+// Class definition for BatchRunner, the non-interactive query mode. Each input line holds
+//   task <TAB> origin [<TAB> destination [<TAB> kWh [<TAB> battery capacity]]]
+// (commas may be used instead of tabs, locations are names or indices, blank lines and lines
+// starting with # are skipped). kWh is the amount to charge for tasks 5, 7, 8 and 9 (or ? for
+// an amount drawn from the seed and the line number) and the current charge for task 11 (10 is
+// Quit in the menu, so it is not a query). Every query gets one output line, in input order,
+// starting with its line number.
+// Parsing, solving and formatting run as a three-stage pipeline on their own threads, passing
+// blocks of queries through bounded queues, so the graph is loaded once and the three stages
+// overlap. Output is collected in a large buffer and written in blocks, never flushed per line
+class BatchRunner {
+private:
+    EVCharging& charging;
+    BatchFormat format;
+
+    static const int blockSize = 4096;       // Queries per block passed between stages
+    static const size_t inputChunk = 1 << 20;  // Bytes read from the input at a time
+    static const size_t outputChunk = 1 << 16; // Bytes buffered before each write
+
+    void formatTsv(const BatchItem& item, string& out) const;
+    void formatJson(const BatchItem& item, string& out) const;
+
+    // Number formatting without streams: fixed decimals for dollars, shortest form for the rest
+    static void appendNumber(string& out, double value, int decimals = -1);
+    static void appendInteger(string& out, long value);
+    static void appendJsonString(string& out, string_view text);
+
+public:
+    BatchRunner(EVCharging& charging, BatchFormat format = BATCH_TSV) : charging(charging), format(format) {}
+
+    // Answer every query of input, writing the results to output. Returns the number of queries
+    long run(FILE* input, FILE* output);
+
+    // Parse one line into a query (or an error); returns false for blank and comment lines
+    bool parseLine(string_view line, BatchItem& item) const;
+    // Resolve a location field given as a name or an index (-1 if it is neither)
+    int parseLocation(string_view field) const;
+    // Append the result line of one answered query to the output buffer
+    void formatItem(const BatchItem& item, string& out) const;
+    // Append a named set of values as one line ("# name key=value ..." in TSV, {"name":{...}} in
+    // JSON), for replies that are not query answers
+    void formatRecord(const char* name, const vector<pair<string, double>>& values, string& out) const;
+};
+
+
+// Function to run the pipeline
+// The parser thread reads the input in large chunks and cuts them into lines; the calling
+// thread solves, so the engine and its caches are only ever used from one thread; the
+// formatter thread renders the answers and writes them out
+long BatchRunner::run(FILE* input, FILE* output) {
+    BoundedQueue<vector<BatchItem>> parsed(4), solved(4);
+    long count = 0;
+
+    thread parser([&]() {
+        vector<char> buffer(inputChunk);
+        string carry; // Partial line left over from the previous chunk
+        vector<BatchItem> block;
+        long lineNumber = 0;
+
+        auto handleLine = [&](string_view line) {
+            BatchItem item;
+            item.number = ++lineNumber;
+            if (!parseLine(line, item))
+                return;
+            block.push_back(move(item));
+            if ((int)block.size() == blockSize) {
+                parsed.push(move(block));
+                block = vector<BatchItem>();
+                block.reserve(blockSize);
+            }
+        };
+
+        block.reserve(blockSize);
+        size_t length;
+        while ((length = fread(buffer.data(), 1, buffer.size(), input)) > 0) {
+            const char* start = buffer.data();
+            const char* end = start + length;
+
+            // Complete the line carried over from the last chunk
+            if (!carry.empty()) {
+                const char* newline = (const char*)memchr(start, '\n', end - start);
+                if (newline == nullptr) {
+                    carry.append(start, end);
+                    continue;
+                }
+                carry.append(start, newline);
+                handleLine(carry);
+                carry.clear();
+                start = newline + 1;
+            }
+
+            // Every complete line in the chunk is parsed straight from the buffer
+            for (const char* newline; (newline = (const char*)memchr(start, '\n', end - start)) != nullptr; start = newline + 1)
+                handleLine(string_view(start, newline - start));
+            carry.assign(start, end);
+        }
+        if (!carry.empty())
+            handleLine(carry);
+
+        if (!block.empty())
+            parsed.push(move(block));
+        parsed.close();
+    });
+
+    thread formatter([&]() {
+        string out;
+        out.reserve(outputChunk * 2);
+        if (format == BATCH_TSV)
+            out += "# query\ttask\tstatus\tstations\tcharged_kwh\tdistance_km\tcharging_cost\ttravel_cost\ttotal_cost\tarrival_kwh\tpath\n";
+
+        vector<BatchItem> block;
+        while (solved.pop(block)) {
+            for (const BatchItem& item : block) {
+                formatItem(item, out);
+                if (out.size() >= outputChunk) {
+                    fwrite(out.data(), 1, out.size(), output);
+                    out.clear();
+                }
+            }
+        }
+        fwrite(out.data(), 1, out.size(), output);
+        fflush(output);
+    });
+
+    // Solve on this thread, block by block
+    vector<BatchItem> block;
+    while (parsed.pop(block)) {
+        for (BatchItem& item : block)
+            if (item.error.empty())
+                item.result = charging.answer(item.query);
+        count += (long)block.size();
+        solved.push(move(block));
+    }
+    solved.close();
+
+    parser.join();
+    formatter.join();
+    return count;
+}
+
+
+// Function to parse one query line
+bool BatchRunner::parseLine(string_view line, BatchItem& item) const {
+    // Drop a carriage return left by Windows line endings and skip blank and comment lines
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+    size_t first = line.find_first_not_of(" \t");
+    if (first == string_view::npos || line[first] == '#')
+        return false;
+
+    // Split the line into at most five fields
+    string_view fields[5];
+    int fieldCount = 0;
+    while (fieldCount < 5) {
+        size_t separator = line.find_first_of("\t,");
+        fields[fieldCount++] = line.substr(0, separator);
+        if (separator == string_view::npos)
+            break;
+        line.remove_prefix(separator + 1);
+    }
+
+    Query& query = item.query;
+    const char* taskEnd = fields[0].data() + fields[0].size();
+    if (from_chars(fields[0].data(), taskEnd, query.task).ptr != taskEnd || query.task < 4 || query.task > 11 || query.task == 10) {
+        item.error = "unknown task: " + string(fields[0]);
+        return true;
+    }
+
+    // Every task needs an origin; tasks 8, 9 and 11 also need a destination
+    bool needsDestination = query.task >= 8;
+    bool needsAmount = query.task == 5 || query.task >= 7;
+    if (fieldCount < 2 || (needsDestination && fieldCount < 3) || (needsAmount && fieldCount < (needsDestination ? 4 : 3))) {
+        item.error = "missing fields";
+        return true;
+    }
+
+    query.origin = parseLocation(fields[1]);
+    if (query.origin == -1) {
+        item.error = "unknown location: " + string(fields[1]);
+        return true;
+    }
+
+    int next = 2;
+    if (needsDestination) {
+        query.destination = parseLocation(fields[next]);
+        if (query.destination == -1) {
+            item.error = "unknown location: " + string(fields[next]);
+            return true;
+        }
+        next++;
+    }
+
+    if (needsAmount && fields[next] == "?" && query.task != 11) {
+        // A made-up amount, fixed by the seed and the line number, so runs replay exactly
+        query.chargingAmount = ChargingAmount::forKey(item.number);
+        next++;
+    } else if (needsAmount) {
+        const char* amountEnd = fields[next].data() + fields[next].size();
+        if (from_chars(fields[next].data(), amountEnd, query.chargingAmount).ptr != amountEnd || query.chargingAmount < 0) {
+            item.error = "invalid kWh: " + string(fields[next]);
+            return true;
+        }
+        next++;
+    }
+
+    if (query.task == 11 && next < fieldCount) {
+        const char* capacityEnd = fields[next].data() + fields[next].size();
+        if (from_chars(fields[next].data(), capacityEnd, query.batteryCapacity).ptr != capacityEnd || query.batteryCapacity <= 0) {
+            item.error = "invalid battery capacity: " + string(fields[next]);
+            return true;
+        }
+    }
+    return true;
+}
+
+
+// Function to resolve a location field
+int BatchRunner::parseLocation(string_view field) const {
+    int index = charging.findLocation(string(field));
+    if (index != -1)
+        return index;
+
+    // Not a name; accept a location index
+    const char* end = field.data() + field.size();
+    if (!field.empty() && from_chars(field.data(), end, index).ptr == end && index >= 0 && index < charging.getNumberOfLocations())
+        return index;
+    return -1;
+}
+
+
+// Function to append a number to the output
+void BatchRunner::appendNumber(string& out, double value, int decimals) {
+    char text[64];
+    to_chars_result result = decimals < 0 ? to_chars(text, text + sizeof(text), value)
+                                          : to_chars(text, text + sizeof(text), value, chars_format::fixed, decimals);
+    // Values too large for fixed notation in the buffer fall back to the shortest form
+    if (result.ec != errc())
+        result = to_chars(text, text + sizeof(text), value);
+    out.append(text, result.ptr);
+}
+
+
+// Function to append an integer to the output
+void BatchRunner::appendInteger(string& out, long value) {
+    char text[24];
+    out.append(text, to_chars(text, text + sizeof(text), value).ptr);
+}
+
+
+// Function to append a quoted, escaped JSON string to the output
+void BatchRunner::appendJsonString(string& out, string_view text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if ((unsigned char)c < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+
+// Function to append the line of one answer in the chosen format
+void BatchRunner::formatItem(const BatchItem& item, string& out) const {
+    EV_TIMER("formatItem");
+    if (format == BATCH_JSON)
+        formatJson(item, out);
+    else
+        formatTsv(item, out);
+}
+
+
+// Function to write one TSV line. Lists are joined with ';', and fields that do not apply to the task are left empty
+void BatchRunner::formatTsv(const BatchItem& item, string& out) const {
+    const QueryResult& result = item.result;
+    int task = item.query.task;
+
+    appendInteger(out, item.number);
+    out += '\t';
+    appendInteger(out, task);
+    out += '\t';
+    if (!item.error.empty()) {
+        out += "error: ";
+        out += item.error;
+        out += "\t\t\t\t\t\t\t\t\n";
+        return;
+    }
+    out += result.found ? "ok" : "none";
+
+    out += '\t';
+    for (size_t i = 0; i < result.stations.size(); i++) {
+        if (i > 0)
+            out += ';';
+        out += charging.locationName(result.stations[i]);
+    }
+    out += '\t';
+    for (size_t i = 0; i < result.charged.size(); i++) {
+        if (i > 0)
+            out += ';';
+        appendNumber(out, result.charged[i]);
+    }
+    out += '\t';
+    if (task == 6 && result.found)
+        appendNumber(out, result.distance);
+    out += '\t';
+    if (task != 4 && task != 6 && result.found) {
+        appendNumber(out, result.chargingCost, 2);
+        out += '\t';
+        appendNumber(out, result.travelCost, 2);
+        out += '\t';
+        appendNumber(out, result.chargingCost + result.travelCost, 2);
+    } else {
+        out += "\t\t";
+    }
+    out += '\t';
+    if (task == 11 && result.found)
+        appendNumber(out, result.arrivalCharge);
+    out += '\t';
+    for (size_t i = 0; i < result.path.size(); i++) {
+        if (i > 0)
+            out += ';';
+        out += charging.locationName(result.path[i]);
+    }
+    out += '\n';
+}
+
+
+// Function to write one JSON object per line (JSON Lines); only the fields that apply to the task are written
+void BatchRunner::formatJson(const BatchItem& item, string& out) const {
+    const QueryResult& result = item.result;
+    int task = item.query.task;
+
+    out += "{\"query\":";
+    appendInteger(out, item.number);
+    out += ",\"task\":";
+    appendInteger(out, task);
+    if (!item.error.empty()) {
+        out += ",\"status\":\"error\",\"error\":";
+        appendJsonString(out, item.error);
+        out += "}\n";
+        return;
+    }
+    out += result.found ? ",\"status\":\"ok\"" : ",\"status\":\"none\"";
+    if (!result.found) {
+        out += "}\n";
+        return;
+    }
+
+    out += ",\"stations\":[";
+    for (size_t i = 0; i < result.stations.size(); i++) {
+        if (i > 0)
+            out += ',';
+        appendJsonString(out, charging.locationName(result.stations[i]));
+    }
+    out += ']';
+    if (!result.charged.empty()) {
+        out += ",\"charged_kwh\":[";
+        for (size_t i = 0; i < result.charged.size(); i++) {
+            if (i > 0)
+                out += ',';
+            appendNumber(out, result.charged[i]);
+        }
+        out += ']';
+    }
+    if (task == 6) {
+        out += ",\"distance_km\":";
+        appendNumber(out, result.distance);
+    }
+    if (task != 4 && task != 6) {
+        out += ",\"charging_cost\":";
+        appendNumber(out, result.chargingCost, 2);
+        out += ",\"travel_cost\":";
+        appendNumber(out, result.travelCost, 2);
+        out += ",\"total_cost\":";
+        appendNumber(out, result.chargingCost + result.travelCost, 2);
+    }
+    if (task == 11) {
+        out += ",\"arrival_kwh\":";
+        appendNumber(out, result.arrivalCharge);
+    }
+    if (!result.path.empty()) {
+        out += ",\"path\":[";
+        for (size_t i = 0; i < result.path.size(); i++) {
+            if (i > 0)
+                out += ',';
+            appendJsonString(out, charging.locationName(result.path[i]));
+        }
+        out += ']';
+    }
+    out += "}\n";
+}
+
+
+
+// Function to write a line that is not a query answer
+void BatchRunner::formatRecord(const char* name, const vector<pair<string, double>>& values, string& out) const {
+    if (format == BATCH_JSON) {
+        out += '{';
+        appendJsonString(out, name);
+        out += ":{";
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0)
+                out += ',';
+            appendJsonString(out, values[i].first);
+            out += ':';
+            appendNumber(out, values[i].second);
+        }
+        out += "}}\n";
+        return;
+    }
+
+    out += "# ";
+    out += name;
+    for (const pair<string, double>& value : values) {
+        out += ' ';
+        out += value.first;
+        out += '=';
+        appendNumber(out, value.second);
+    }
+    out += '\n';
+}
+
+#endif /* BatchMode_h */
@@ -0,0 +1,866 @@
+//
+//  Benchmark.cpp
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+//  Build: g++ -std=c++17 -O2 -pthread Benchmark.cpp -o Benchmark
+//  Run:   ./Benchmark
+//
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <new>
+
+using namespace std;
+
+#include "WeightedGraph.h"
+#include "ChargingRouter.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "NetworkSnapshot.h"
+#include "NameIndex.h"
+#include "StationTable.h"
+#include "BatchMode.h"
+#include "RoadNetworkGenerator.h"
+
+// Heap allocations made by the calling thread so far, counted by the replacement operator new below
+static thread_local long allocationCount = 0;
+
+// Not inlined either, so the compiler does not see the malloc and warn that the operator
+// delete below frees it
+__attribute__((noinline)) void* operator new(size_t size) {
+    allocationCount++;
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr)
+        throw bad_alloc();
+    return memory;
+}
+
+// Not inlined, so the compiler does not pair the free with a new it cannot see
+__attribute__((noinline)) void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+__attribute__((noinline)) void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+// Write a random connected road-like graph of the given size to fileName in the
+// Weights.txt adjacency matrix format. Every vertex is joined to the previous one
+// (so the graph is connected) plus a few random extra roads, giving about the same
+// average degree as the sample network (84 edges over 24 vertices)
+void writeRandomGraph(const string& fileName, int size, unsigned seed) {
+    mt19937 generator(seed);
+    uniform_real_distribution<double> distance(1.0, 40.0);
+    vector<vector<double>> matrix(size, vector<double>(size, 0));
+
+    // Add one undirected road of random length, rounded to one decimal place like Weights.txt
+    auto addRoad = [&](int i, int j) {
+        if (i == j)
+            return;
+        double length = (int)(distance(generator) * 10) / 10.0;
+        matrix[i][j] = length;
+        matrix[j][i] = length;
+    };
+
+    for (int i = 1; i < size; i++)
+        addRoad(i, uniform_int_distribution<int>(0, i - 1)(generator));
+    for (int i = 0; i < size; i++)
+        if (generator() % 4 == 0)
+            addRoad(i, uniform_int_distribution<int>(0, size - 1)(generator));
+
+    ofstream outfile(fileName);
+    for (int i = 0; i < size; i++) {
+        for (int j = 0; j < size; j++)
+            outfile << matrix[i][j] << (j + 1 < size ? "\t" : "");
+        outfile << "\n";
+    }
+}
+
+// Time the average cost of one single-source query, in microseconds
+template <class Query>
+double timeQueries(int size, Query query) {
+    int queries = max(8, 20000 / size);
+    double checksum = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        checksum += query((q * 7919) % size)[size - 1];
+    auto stop = chrono::steady_clock::now();
+
+    // Use the checksum so the queries cannot be optimised away
+    if (checksum < 0)
+        cout << checksum;
+
+    return chrono::duration<double, micro>(stop - start).count() / queries;
+}
+
+// Compare the original dense O(V^2) scan against the heap-based CSR solver
+void benchmarkShortestPath() {
+    const string fileName = "BenchmarkWeights.txt";
+
+    cout << "Single-source shortest path, average time per query" << endl;
+    cout << setw(10) << "Vertices" << setw(16) << "Dense (us)" << setw(16) << "Heap (us)" << setw(12) << "Speedup" << endl;
+
+    for (int size = 16; size <= 2048; size *= 2) {
+        writeRandomGraph(fileName, size, size);
+        WeightedGraphType graph(size, fileName.c_str());
+
+        double dense = timeQueries(size, [&](int source) { return graph.shortestPathDense(source); });
+        double heap = timeQueries(size, [&](int source) { return graph.shortestPath(source); });
+
+        cout << setw(10) << size << setw(16) << fixed << setprecision(2) << dense << setw(16) << heap
+             << setw(11) << dense / heap << "x" << endl;
+    }
+
+    remove(fileName.c_str());
+    cout << endl;
+}
+
+// Write the sample network replicated copies times as an EDGE_LIST file. Copy k is
+// joined to copy k + 1 and to one random earlier copy by a 10 km link, so the result
+// is one connected graph with the same local structure as Weights.txt
+int writeReplicatedGraph(const string& fileName, int copies, unsigned seed) {
+    WeightedGraphType sample(24);
+    int size = sample.getNumberOfVertices();
+    mt19937 generator(seed);
+
+    ofstream outfile(fileName);
+    auto addRoad = [&](int i, int j, double length) {
+        outfile << i << ' ' << j << ' ' << length << '\n' << j << ' ' << i << ' ' << length << '\n';
+    };
+
+    for (int k = 0; k < copies; k++) {
+        int base = k * size;
+        for (int v = 0; v < size; v++)
+            for (int e = sample.edgeBegin(v); e < sample.edgeEnd(v); e++)
+                outfile << base + v << ' ' << base + sample.edgeTarget(e) << ' ' << sample.edgeWeight(e) << '\n';
+
+        if (k + 1 < copies)
+            addRoad(base + generator() % size, base + size + generator() % size, 10);
+        if (k > 1)
+            addRoad(base + generator() % size, (generator() % (k - 1)) * size + generator() % size, 10);
+    }
+    return copies * size;
+}
+
+// Measure batch query throughput as the worker pool grows
+void benchmarkBatchThroughput() {
+    const string fileName = "BenchmarkEdges.txt";
+    int size = writeReplicatedGraph(fileName, 2000, 1);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+
+    // A fixed batch of sources spread over the whole graph
+    vector<int> sources(512);
+    for (size_t q = 0; q < sources.size(); q++)
+        sources[q] = (int)((q * 7919) % size);
+
+    cout << "Batch single-source queries on the sample network x2000 (" << size << " vertices, "
+         << graph.getNumberOfEdges() << " edges)" << endl;
+    cout << setw(10) << "Threads" << setw(16) << "Queries/s" << setw(12) << "Scaling" << endl;
+
+    vector<ShortestPathTree> results;
+    double single = 0;
+    int cores = max(1, (int)thread::hardware_concurrency());
+
+    // 1, 2, 4, ... threads, always ending with one per core
+    vector<int> threadCounts;
+    for (int threads = 1; threads < cores; threads *= 2)
+        threadCounts.push_back(threads);
+    threadCounts.push_back(cores);
+
+    for (int threads : threadCounts) {
+        graph.setWorkerThreads(threads);
+        graph.shortestPaths(sources, results); // Warm up the pool and the result buffers
+
+        auto start = chrono::steady_clock::now();
+        graph.shortestPaths(sources, results);
+        auto stop = chrono::steady_clock::now();
+
+        double rate = sources.size() / chrono::duration<double>(stop - start).count();
+        if (threads == 1)
+            single = rate;
+        cout << setw(10) << threads << setw(16) << fixed << setprecision(0) << rate
+             << setw(11) << setprecision(2) << rate / single << "x" << endl;
+    }
+    cout << endl;
+}
+
+// Read the charger flags and prices of Locations.txt, repeated copies times
+void readReplicatedStations(int copies, vector<bool>& chargerInstalled, vector<double>& chargingPrices) {
+    vector<bool> sampleChargers;
+    vector<double> samplePrices;
+    ifstream infile("Locations.txt");
+    string name, charger, price;
+
+    while (getline(infile, name, ',') && getline(infile, charger, ',') && getline(infile, price)) {
+        sampleChargers.push_back(stoi(charger) == 1);
+        samplePrices.push_back(stod(price));
+    }
+
+    for (int k = 0; k < copies; k++) {
+        chargerInstalled.insert(chargerInstalled.end(), sampleChargers.begin(), sampleChargers.end());
+        chargingPrices.insert(chargingPrices.end(), samplePrices.begin(), samplePrices.end());
+    }
+}
+
+// Measure battery-constrained multi-stop planning on a 10k-vertex network
+void benchmarkChargingRouter() {
+    const string fileName = "BenchmarkEdges.txt";
+    int copies = 417;
+    int size = writeReplicatedGraph(fileName, copies, 2);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+
+    vector<bool> chargerInstalled;
+    vector<double> chargingPrices;
+    readReplicatedStations(copies, chargerInstalled, chargingPrices);
+    ChargingRouter router(graph, chargerInstalled, chargingPrices);
+
+    BatteryProfile battery;
+    battery.capacity = 40;
+    battery.initialCharge = 10;
+
+    cout << "Battery-constrained trip planning (" << size << " vertices, 40 kWh battery)" << endl;
+    cout << setw(10) << "Trips" << setw(16) << "Avg (ms)" << setw(16) << "Avg stops" << endl;
+
+    int trips = 20, stops = 0;
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < trips; t++) {
+        ChargingPlan plan = router.plan((t * 7919) % size, (t * 104729 + 13) % size, battery);
+        stops += (int)plan.stops.size();
+    }
+    auto stop = chrono::steady_clock::now();
+
+    cout << setw(10) << trips << setw(16) << fixed << setprecision(2)
+         << chrono::duration<double, milli>(stop - start).count() / trips
+         << setw(16) << (double)stops / trips << endl << endl;
+}
+
+// Measure contraction hierarchy preprocessing and point-to-point query speed against Dijkstra
+void benchmarkContractionHierarchy() {
+    const string fileName = "BenchmarkEdges.txt";
+    cout << "Contraction hierarchy, point-to-point queries on the replicated sample network" << endl;
+    cout << setw(10) << "Vertices" << setw(16) << "Preprocess (ms)" << setw(12) << "Shortcuts"
+         << setw(16) << "Dijkstra (us)" << setw(12) << "CH (us)" << setw(12) << "Speedup" << endl;
+
+    for (int copies : {42, 417}) {
+        int size = writeReplicatedGraph(fileName, copies, 3);
+        WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+        remove(fileName.c_str());
+
+        auto start = chrono::steady_clock::now();
+        ContractionHierarchy hierarchy(graph);
+        double preprocess = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        int queries = 200;
+        size_t hops = 0; // Path lengths, so the queries cannot be optimised away
+
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < queries; q++)
+            hops += graph.shortestPath((q * 7919) % size, (q * 104729 + 13) % size).size();
+        double dijkstra = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+        start = chrono::steady_clock::now();
+        for (int q = 0; q < queries; q++)
+            hops += hierarchy.shortestPath((q * 7919) % size, (q * 104729 + 13) % size).size();
+        double contracted = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+        if (hops == 0)
+            cout << "no paths found" << endl;
+
+        cout << setw(10) << size << setw(16) << fixed << setprecision(1) << preprocess
+             << setw(12) << hierarchy.getShortcutCount() << setw(16) << dijkstra << setw(12) << contracted
+             << setw(11) << setprecision(1) << dijkstra / contracted << "x" << endl;
+    }
+    cout << endl;
+}
+
+// Measure A* with landmarks (ALT) against Dijkstra's algorithm for point-to-point queries on a
+// network without coordinates, for both ways of choosing the landmarks and several counts
+void benchmarkLandmarks() {
+    const string fileName = "BenchmarkEdges.txt";
+    int size = writeReplicatedGraph(fileName, 417, 3);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+
+    int queries = 1000;
+    vector<int> path;
+    size_t hops = 0;
+    long settled = 0;
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        hops += graph.shortestPathDijkstra((q * 7919) % size, (q * 104729 + 13) % size, path) < DBL_MAX;
+        settled += WeightedGraphType::lastSearchSettled();
+    }
+    double dijkstra = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+    cout << "Landmarks (ALT), point-to-point queries on the replicated sample network, " << size << " vertices" << endl;
+    cout << "Dijkstra: " << fixed << setprecision(1) << dijkstra << " us, " << settled / queries << " vertices settled per query" << endl;
+    cout << setw(10) << "Selection" << setw(11) << "Landmarks" << setw(16) << "Preprocess (ms)" << setw(14) << "KB/landmark"
+         << setw(10) << "Settled" << setw(12) << "ALT (us)" << setw(12) << "Speedup" << endl;
+
+    for (LandmarkSelection selection : {LANDMARKS_FARTHEST, LANDMARKS_AVOID}) {
+        for (int count : {4, 8, 16}) {
+            LandmarkIndex landmarks;
+            start = chrono::steady_clock::now();
+            landmarks.build(graph, count, selection);
+            double preprocess = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+            settled = 0;
+            start = chrono::steady_clock::now();
+            for (int q = 0; q < queries; q++) {
+                hops += landmarks.shortestPath((q * 7919) % size, (q * 104729 + 13) % size, path) < DBL_MAX;
+                settled += WeightedGraphType::lastSearchSettled();
+            }
+            double alt = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+            cout << setw(10) << (selection == LANDMARKS_FARTHEST ? "farthest" : "avoid") << setw(11) << count
+                 << setw(16) << setprecision(1) << preprocess << setw(14) << landmarks.bytesPerLandmark() / 1024.0
+                 << setw(10) << settled / queries << setw(12) << alt << setw(11) << dijkstra / alt << "x" << endl;
+        }
+    }
+    if (hops == 0)
+        cout << "no paths found" << endl;
+    cout << endl;
+}
+
+// Time shortest path trees and point-to-point queries over the fixed-point weights with one
+// kind of queue, in microseconds per query, and find the largest difference from reference
+template <class Queue>
+void timeFixedPointQueue(WeightedGraphType& graph, const vector<ShortestPathTree>& reference, int queries,
+                         double& treeTime, double& pathTime, double& largestError) {
+    int size = graph.getNumberOfVertices();
+    ShortestPathTree tree;
+    vector<int> path;
+    largestError = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++) {
+        graph.shortestPathTreeFixed<Queue>((q * 7919) % size, tree);
+        if (q < (int)reference.size())
+            for (int v = 0; v < size; v++)
+                largestError = max(largestError, fabs(tree.distance[v] - reference[q].distance[v]));
+    }
+    treeTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        graph.shortestPathFixed<Queue>((q * 7919) % size, (q * 104729 + 13) % size, path);
+    pathTime = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+}
+
+// Compare the priority queues over the road distances scaled to tenths of a km against the binary
+// heap over doubles, for whole trees and for point-to-point queries. The error column is the
+// largest difference of a tree distance from the double search, which only rounding can cause
+void benchmarkPriorityQueues() {
+    const string fileName = "BenchmarkEdges.txt";
+    int size = writeReplicatedGraph(fileName, 417, 3);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+    graph.useFixedPointWeights(10);
+
+    int queries = 200;
+    vector<ShortestPathTree> reference(20);
+    DijkstraWorkspace workspace;
+    vector<int> path;
+    auto start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        graph.shortestPathTree((q * 7919) % size, reference[q % reference.size()], workspace);
+    double doubleTree = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+    for (int q = 0; q < (int)reference.size(); q++)
+        graph.shortestPathTree((q * 7919) % size, reference[q], workspace);
+
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++)
+        graph.shortestPathDijkstra((q * 7919) % size, (q * 104729 + 13) % size, path);
+    double doublePath = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+
+    cout << "Priority queues over fixed-point distances (tenths of a km), replicated sample network, " << size << " vertices" << endl;
+    cout << left << setw(24) << "Queue" << right << setw(12) << "Tree (us)" << setw(10) << "Speedup"
+         << setw(18) << "Point (us)" << setw(10) << "Speedup" << setw(16) << "Error (km)" << endl;
+    cout << left << setw(24) << "Binary heap, double" << right << setw(12) << fixed << setprecision(1) << doubleTree
+         << setw(9) << 1.0 << "x" << setw(18) << doublePath << setw(9) << 1.0 << "x" << setw(16) << "-" << endl;
+
+    struct Row {
+        const char* name;
+        function<void(double&, double&, double&)> time;
+    };
+    vector<Row> rows = {
+        {"Binary heap", [&](double& t, double& p, double& e) { timeFixedPointQueue<BinaryHeapQueue>(graph, reference, queries, t, p, e); }},
+        {"4-ary heap", [&](double& t, double& p, double& e) { timeFixedPointQueue<QuaternaryHeapQueue>(graph, reference, queries, t, p, e); }},
+        {"Radix heap", [&](double& t, double& p, double& e) { timeFixedPointQueue<RadixHeapQueue>(graph, reference, queries, t, p, e); }},
+        {"Dial", [&](double& t, double& p, double& e) { timeFixedPointQueue<DialQueue>(graph, reference, queries, t, p, e); }},
+    };
+    for (const Row& row : rows) {
+        double treeTime, pathTime, largestError;
+        row.time(treeTime, pathTime, largestError);
+        cout << left << setw(24) << row.name << right << setw(12) << setprecision(1) << treeTime
+             << setw(9) << doubleTree / treeTime << "x" << setw(18) << pathTime << setw(9) << doublePath / pathTime << "x"
+             << setw(16) << scientific << setprecision(1) << largestError << fixed << endl;
+    }
+    cout << endl;
+}
+
+// Measure repairing a shortest path tree after a road weight change against rebuilding it
+void benchmarkIncrementalRepair() {
+    const string fileName = "BenchmarkEdges.txt";
+    int size = writeReplicatedGraph(fileName, 417, 4);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+
+    mt19937 generator(4);
+    ShortestPathTree tree = graph.shortestPathTree(0);
+    int updates = 2000, mismatches = 0;
+    double repairTime = 0, rebuildTime = 0;
+
+    for (int u = 0; u < updates; u++) {
+        // Pick a random road and make it three times longer or shorter
+        int from = generator() % size;
+        if (graph.edgeBegin(from) == graph.edgeEnd(from))
+            continue;
+        int e = graph.edgeBegin(from) + generator() % (graph.edgeEnd(from) - graph.edgeBegin(from));
+        int to = graph.edgeTarget(e);
+        double oldWeight = graph.edgeWeight(e);
+        graph.updateEdgeWeight(from, to, generator() % 2 ? oldWeight * 3 : oldWeight / 3);
+
+        auto start = chrono::steady_clock::now();
+        graph.repairShortestPathTree(tree, from, to, oldWeight);
+        auto middle = chrono::steady_clock::now();
+        ShortestPathTree rebuilt = graph.shortestPathTree(0);
+        auto stop = chrono::steady_clock::now();
+
+        repairTime += chrono::duration<double, micro>(middle - start).count();
+        rebuildTime += chrono::duration<double, micro>(stop - middle).count();
+        for (int v = 0; v < size; v++)
+            mismatches += fabs(tree.distance[v] - rebuilt.distance[v]) > 1e-6;
+    }
+
+    cout << "Shortest path tree repair after a road weight change (" << size << " vertices, " << updates << " updates)" << endl;
+    cout << setw(16) << "Repair (us)" << setw(16) << "Rebuild (us)" << setw(12) << "Speedup" << setw(14) << "Mismatches" << endl;
+    cout << setw(16) << fixed << setprecision(2) << repairTime / updates << setw(16) << rebuildTime / updates
+         << setw(11) << setprecision(1) << rebuildTime / repairTime << "x" << setw(14) << mismatches << endl << endl;
+}
+
+// Compare loading a graph by parsing text with the old stream reader, with the mapped
+// from_chars scanner, and from a binary snapshot
+void benchmarkLoader() {
+    const string matrixFile = "BenchmarkMatrix.txt", edgeFile = "BenchmarkEdges.txt", snapshotFile = "Benchmark.snap";
+    writeRandomGraph(matrixFile, 2048, 5);
+    int edgeListSize = writeReplicatedGraph(edgeFile, 4167, 5);
+
+    cout << "Graph loading (ms)" << endl;
+    cout << setw(28) << "File" << setw(14) << "Stream" << setw(14) << "Scanner" << setw(14) << "Snapshot" << setw(12) << "Equal" << endl;
+
+    for (int format = 0; format < 2; format++) {
+        const string& fileName = format == 0 ? matrixFile : edgeFile;
+        int size = format == 0 ? 2048 : edgeListSize;
+
+        // Stream reader as used before the scanner: one >> per number
+        auto start = chrono::steady_clock::now();
+        ifstream infile(fileName);
+        double value, checksum = 0;
+        while (infile >> value)
+            checksum += value;
+        auto middle = chrono::steady_clock::now();
+
+        WeightedGraphType graph(format == 0 ? size : 0, fileName.c_str(), format == 0 ? ADJACENCY_MATRIX : EDGE_LIST);
+        auto stop = chrono::steady_clock::now();
+
+        vector<string> names(size, "Location");
+        vector<bool> chargers(size, false);
+        vector<double> prices(size, -1), latitudes(size, NAN), longitudes(size, NAN);
+        NetworkSnapshot::write(snapshotFile.c_str(), graph, names, chargers, prices, latitudes, longitudes, 1, 2);
+
+        auto snapshotStart = chrono::steady_clock::now();
+        WeightedGraphType loaded(0, nullptr);
+        bool ok = NetworkSnapshot::read(snapshotFile.c_str(), 1, 2, loaded, names, chargers, prices, latitudes, longitudes);
+        auto snapshotStop = chrono::steady_clock::now();
+
+        ok = ok && loaded.getEdgeTargets() == graph.getEdgeTargets() && loaded.getEdgeWeights() == graph.getEdgeWeights();
+        string label = (format == 0 ? "matrix, " : "edge list, ") + to_string(size) + " vertices";
+        cout << setw(28) << label << setw(14) << fixed << setprecision(1)
+             << chrono::duration<double, milli>(middle - start).count() << setw(14)
+             << chrono::duration<double, milli>(stop - middle).count() << setw(14)
+             << chrono::duration<double, milli>(snapshotStop - snapshotStart).count() << setw(12) << (ok ? "yes" : "no") << endl;
+    }
+    cout << endl;
+
+    remove(matrixFile.c_str());
+    remove(edgeFile.c_str());
+    remove(snapshotFile.c_str());
+}
+
+// Measure starting the engine end to end on a 50k-location network: from the text files (parsing
+// them and contracting the graph) against from the snapshot and the saved hierarchy, as a
+// restart after --snapshot would. Both engines must give the same answers
+void benchmarkEngineStartup() {
+    const string weightsFile = "BenchmarkStartWeights.txt", locationsFile = "BenchmarkStartLocations.txt";
+    const string snapshotFile = weightsFile + ".snap", hierarchyFile = weightsFile + ".ch";
+    RoadNetworkOptions options;
+    options.locations = 50000;
+    RoadNetworkGenerator::write(options, weightsFile.c_str(), locationsFile.c_str());
+    remove(snapshotFile.c_str());
+    remove(hierarchyFile.c_str());
+
+    auto start = chrono::steady_clock::now();
+    EVCharging parsed(locationsFile, weightsFile, EDGE_LIST);
+    auto stop = chrono::steady_clock::now();
+    double textTime = chrono::duration<double, milli>(stop - start).count();
+    parsed.writeSnapshot();
+
+    // Best of a few starts, so the page cache is warm as on a restarting server
+    double snapshotTime = DBL_MAX;
+    bool equal = true;
+    for (int round = 0; round < 5; round++) {
+        start = chrono::steady_clock::now();
+        EVCharging loaded(locationsFile, weightsFile, EDGE_LIST);
+        stop = chrono::steady_clock::now();
+        snapshotTime = min(snapshotTime, chrono::duration<double, milli>(stop - start).count());
+
+        if (round == 0) {
+            for (int q = 0; q < 200; q++) {
+                Query query;
+                query.task = 8 + q % 2;
+                query.origin = (q * 7919) % options.locations;
+                query.destination = (q * 104729 + 13) % options.locations;
+                query.chargingAmount = 30;
+                QueryResult a = parsed.answer(query), b = loaded.answer(query);
+                equal = equal && a.path == b.path && a.chargingCost + a.travelCost == b.chargingCost + b.travelCost;
+            }
+        }
+    }
+
+    cout << "Engine startup, " << options.locations << " locations (ms)" << endl;
+    cout << setw(24) << "Text files" << setw(24) << "Snapshot + hierarchy" << setw(12) << "Speedup" << setw(12) << "Equal" << endl;
+    cout << setw(24) << fixed << setprecision(1) << textTime << setw(24) << snapshotTime << setw(11) << setprecision(0)
+         << textTime / snapshotTime << "x" << setw(12) << (equal ? "yes" : "no") << endl << endl;
+
+    remove(weightsFile.c_str());
+    remove(locationsFile.c_str());
+    remove(snapshotFile.c_str());
+    remove(hierarchyFile.c_str());
+}
+
+// Compare resolving location names with a linear scan (the old getIndex) and with the hash index
+void benchmarkNameLookup() {
+    cout << "Location name lookup (ns per query)" << endl;
+    cout << setw(12) << "Names" << setw(16) << "Linear scan" << setw(14) << "Hash index" << setw(12) << "Speedup" << endl;
+
+    for (int count : {24, 1000, 100000}) {
+        vector<string> names(count);
+        for (int i = 0; i < count; i++)
+            names[i] = "Location " + to_string(i * 7919 % count) + " North";
+
+        NameIndex index;
+        index.build(names);
+
+        mt19937 generator(6);
+        int queries = count >= 100000 ? 2000 : 200000;
+        vector<string> wanted(queries);
+        for (string& name : wanted)
+            name = names[generator() % count];
+
+        // The old getIndex: compare against every name until one matches
+        auto start = chrono::steady_clock::now();
+        long found = 0;
+        for (const string& name : wanted)
+            for (int i = 0; i < count; i++)
+                if (names[i] == name) {
+                    found += i;
+                    break;
+                }
+        auto middle = chrono::steady_clock::now();
+        long hashed = 0;
+        for (const string& name : wanted)
+            hashed += index.find(name);
+        auto stop = chrono::steady_clock::now();
+
+        double linear = chrono::duration<double, nano>(middle - start).count() / queries;
+        double hash = chrono::duration<double, nano>(stop - middle).count() / queries;
+        cout << setw(12) << count << setw(16) << fixed << setprecision(1) << linear << setw(14) << hash
+             << setw(11) << linear / hash << "x" << (found == hashed ? "" : "  (mismatch)") << endl;
+    }
+    cout << endl;
+}
+
+// Compare station queries on Location objects (copy and sort, branchy scan) with the columnar station table
+void benchmarkStationTable() {
+    int count = 1000000, rounds = 20;
+    mt19937 generator(7);
+    vector<Location> rows(count);
+    vector<string> names(count);
+    vector<bool> chargers(count);
+    vector<double> prices(count), travelCosts(count);
+
+    for (int i = 0; i < count; i++) {
+        names[i] = "Location " + to_string(i);
+        chargers[i] = generator() % 3 == 0;
+        prices[i] = chargers[i] ? (generator() % 60) / 100.0 : -1;
+        travelCosts[i] = (generator() % 100000) / 100.0;
+        rows[i] = {i, names[i], chargers[i], prices[i]};
+    }
+    StationTable table;
+    table.build(names, chargers, prices);
+
+    // Price listing: copy and sort the charger rows, or read the maintained order
+    auto start = chrono::steady_clock::now();
+    double checksum = 0; // Ties may come out in any order, so the prices are compared
+    for (int r = 0; r < rounds; r++) {
+        vector<Location> sorted;
+        for (const Location& row : rows)
+            if (row.chargerInstalled)
+                sorted.push_back(row);
+        sort(sorted.begin(), sorted.end());
+        checksum += sorted[sorted.size() / 2].chargingPrice;
+    }
+    auto middle = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        checksum -= table.price(table.byPrice()[table.byPrice().size() / 2]);
+    auto stop = chrono::steady_clock::now();
+    double sortTime = chrono::duration<double, milli>(middle - start).count() / rounds;
+    double orderTime = chrono::duration<double, milli>(stop - middle).count() / rounds;
+
+    // Cheapest station for 30 kWh over every location
+    vector<int> everyLocation(count);
+    for (int i = 0; i < count; i++)
+        everyLocation[i] = i;
+    start = chrono::steady_clock::now();
+    int rowBest = -1, tableBest = -1;
+    for (int r = 0; r < rounds; r++) {
+        double lowest = DBL_MAX;
+        for (int i = 0; i < count; i++) {
+            double cost = travelCosts[i] + 30 * rows[i].chargingPrice;
+            if (rows[i].chargerInstalled && cost < lowest && (rows[i].chargingPrice > 0 || 30 <= 25)) {
+                lowest = cost;
+                rowBest = i;
+            }
+        }
+    }
+    middle = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        double lowest;
+        tableBest = table.cheapestCandidate(everyLocation.data(), travelCosts.data(), count, 30, 25, lowest);
+    }
+    stop = chrono::steady_clock::now();
+    double scanTime = chrono::duration<double, milli>(middle - start).count() / rounds;
+    double kernelTime = chrono::duration<double, milli>(stop - middle).count() / rounds;
+
+    // Chargers at or under 20 cents
+    start = chrono::steady_clock::now();
+    size_t rowMatches = 0, tableMatches = 0;
+    for (int r = 0; r < rounds; r++) {
+        vector<int> matches;
+        for (int i = 0; i < count; i++)
+            if (rows[i].chargerInstalled && rows[i].chargingPrice <= 0.2)
+                matches.push_back(i);
+        rowMatches = matches.size();
+    }
+    middle = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        tableMatches = table.chargersUnderPrice(0.2).size();
+    stop = chrono::steady_clock::now();
+    double filterTime = chrono::duration<double, milli>(middle - start).count() / rounds;
+    double filterKernelTime = chrono::duration<double, milli>(stop - middle).count() / rounds;
+
+    cout << "Station queries over " << count << " locations (ms)" << endl;
+    cout << setw(28) << "Query" << setw(14) << "Location" << setw(14) << "Table" << setw(12) << "Equal" << endl;
+    cout << setw(28) << "Chargers by price" << setw(14) << fixed << setprecision(3) << sortTime << setw(14) << orderTime
+         << setw(12) << (fabs(checksum) < 1e-9 ? "yes" : "no") << endl;
+    cout << setw(28) << "Cheapest station" << setw(14) << scanTime << setw(14) << kernelTime << setw(12) << (rowBest == tableBest ? "yes" : "no") << endl;
+    cout << setw(28) << "Chargers under a price" << setw(14) << filterTime << setw(14) << filterKernelTime
+         << setw(12) << (rowMatches == tableMatches ? "yes" : "no") << endl << endl;
+}
+
+// Measure the answer cache on the sample network: a skewed stream of task 8 and 9 queries
+// (a few popular trips asked again and again) answered directly and through the cache, then
+// the same stream again after a price change has made every cached answer stale
+void benchmarkQueryCache() {
+    EVCharging charging;
+    int locations = charging.getNumberOfLocations(), queries = 200000;
+    mt19937 generator(9);
+
+    // Squaring a uniform draw favours the low indices, so some trips are far more popular
+    vector<Query> stream(queries);
+    for (Query& query : stream) {
+        double u = (generator() % 10000) / 10000.0, v = (generator() % 10000) / 10000.0;
+        query.task = 8 + generator() % 2;
+        query.origin = (int)(u * u * locations);
+        query.destination = (int)(v * v * locations);
+        query.chargingAmount = 10 + (int)(generator() % 5) * 10;
+    }
+
+    auto start = chrono::steady_clock::now();
+    double direct = 0;
+    for (const Query& query : stream) {
+        QueryResult result = query.task == 8 ? charging.findCheapestChargingPath(query.origin, query.destination, query.chargingAmount)
+                                             : charging.findBestChargingPath(query.origin, query.destination, query.chargingAmount);
+        direct += result.chargingCost + result.travelCost;
+    }
+    auto middle = chrono::steady_clock::now();
+    double cached = 0;
+    for (const Query& query : stream) {
+        QueryResult result = charging.answer(query);
+        cached += result.chargingCost + result.travelCost;
+    }
+    auto stop = chrono::steady_clock::now();
+    QueryCacheStats warm = charging.answerCacheStats();
+
+    // Rewriting a charger with its own values still counts as a change and invalidates everything
+    int station = charging.findLocation("Penrith");
+    Location row = charging.locationRow(station);
+    charging.updateChargingStation(station, row.chargerInstalled, row.chargingPrice);
+    for (const Query& query : stream)
+        charging.answer(query);
+    QueryCacheStats after = charging.answerCacheStats();
+
+    double directTime = chrono::duration<double, micro>(middle - start).count() / queries;
+    double cachedTime = chrono::duration<double, micro>(stop - middle).count() / queries;
+    cout << "Answer cache, " << queries << " skewed queries of tasks 8 and 9" << endl;
+    cout << setw(24) << "Direct (us/query)" << setw(14) << fixed << setprecision(2) << directTime << endl;
+    cout << setw(24) << "Cached (us/query)" << setw(14) << cachedTime << endl;
+    cout << setw(24) << "Equal" << setw(14) << (direct == cached ? "yes" : "no") << endl;
+    cout << setw(24) << "Hit rate" << setw(14) << setprecision(3) << warm.hitRate() << endl;
+    cout << setw(24) << "Evictions" << setw(14) << warm.evictions << endl;
+    cout << setw(24) << "Entries" << setw(14) << warm.entries << endl;
+    cout << setw(24) << "Memory (KB)" << setw(14) << setprecision(1) << warm.bytes / 1024.0 << endl;
+    cout << setw(24) << "Invalidated by update" << setw(14) << after.invalidations << endl << endl;
+}
+
+// Measure the batch mode end to end on the sample network: 1M random queries of tasks 4 to 9 and 11
+// are parsed, solved and formatted, with the output discarded
+void benchmarkBatchMode() {
+    EVCharging charging;
+    int locations = charging.getNumberOfLocations(), queries = 1000000;
+    mt19937 generator(8);
+
+    string input;
+    for (int q = 0; q < queries; q++) {
+        int task = 4 + generator() % 7;
+        if (task == 10)
+            task = 11;
+        input += to_string(task) + '\t' + string(charging.locationName(generator() % locations));
+        if (task >= 8)
+            input += '\t' + string(charging.locationName(generator() % locations));
+        if (task == 5 || task >= 7)
+            input += '\t' + to_string(10 + generator() % 41);
+        input += '\n';
+    }
+
+    cout << "Batch mode, " << queries << " queries over " << locations << " locations" << endl;
+    cout << setw(10) << "Format" << setw(14) << "Seconds" << setw(18) << "Queries/s" << endl;
+    for (BatchFormat format : {BATCH_TSV, BATCH_JSON}) {
+        FILE* in = fmemopen((void*)input.data(), input.size(), "r");
+        FILE* out = fopen("/dev/null", "w");
+
+        auto start = chrono::steady_clock::now();
+        long answered = BatchRunner(charging, format).run(in, out);
+        auto stop = chrono::steady_clock::now();
+        fclose(in);
+        fclose(out);
+
+        double seconds = chrono::duration<double>(stop - start).count();
+        cout << setw(10) << (format == BATCH_TSV ? "TSV" : "JSON") << setw(14) << fixed << setprecision(2) << seconds
+             << setw(18) << setprecision(0) << answered / seconds << endl;
+    }
+    cout << endl;
+}
+
+// Count the heap allocations of steady-state queries, after a warm-up pass over the same queries
+// has grown the per-thread buffers to their largest size. The searches that write into caller
+// buffers allocate nothing (AllocationTest fails the build otherwise); the old forms and the task
+// rows, which return a QueryResult, are shown next to them
+void benchmarkQueryAllocations() {
+    const string fileName = "BenchmarkEdges.txt";
+    int size = writeReplicatedGraph(fileName, 417, 3);
+    WeightedGraphType graph(size, fileName.c_str(), EDGE_LIST);
+    remove(fileName.c_str());
+    graph.useFixedPointWeights(10);
+    ContractionHierarchy hierarchy(graph);
+    vector<bool> chargerInstalled;
+    vector<double> chargingPrices;
+    readReplicatedStations(417, chargerInstalled, chargingPrices);
+    EVCharging charging;
+    int locations = charging.getNumberOfLocations();
+
+    vector<int> path;
+    vector<pair<int, double>> found;
+    size_t checksum = 0; // Keeps the results alive
+
+    struct Row {
+        const char* name;
+        function<void(int, int)> query;
+    };
+    vector<Row> rows = {
+        {"Tree, stack path (old)", [&](int o, int d) { checksum += graph.shortestPathTree(o).pathTo(d).size(); }},
+        {"Point-to-point, stack", [&](int o, int d) { checksum += graph.shortestPath(o, d).size(); }},
+        {"Point-to-point, buffer", [&](int o, int d) { graph.shortestPath(o, d, path); checksum += path.size(); }},
+        {"Bidirectional, buffer", [&](int o, int d) { graph.shortestPathBidirectional(o, d, path); checksum += path.size(); }},
+        {"Fixed-point Dial, buffer", [&](int o, int d) { graph.shortestPathFixed<DialQueue>(o, d, path); checksum += path.size(); }},
+        {"Hierarchy, buffer", [&](int o, int d) { hierarchy.shortestPath(o, d, path); checksum += path.size(); }},
+        {"3 nearest, buffer", [&](int o, int) { graph.nearestTargets(o, chargerInstalled, 3, found); checksum += found.size(); }},
+        {"Adjacency, list copy (old)", [&](int o, int) {
+            Span<int> row = graph.getAdjancencyList(o);
+            checksum += list<int>(row.begin(), row.end()).size();
+        }},
+        {"Adjacency, span", [&](int o, int) {
+            for (int v : graph.getAdjancencyList(o))
+                checksum += v;
+        }},
+        {"Task 7 (result only)", [&](int o, int) {
+            checksum += charging.findOtherCheapestStation(o % locations, 30).stations.size();
+        }},
+        {"Task 9 (result only)", [&](int o, int d) {
+            checksum += charging.findBestChargingPath(o % locations, d % locations, 40).path.size();
+        }},
+    };
+
+    cout << "Heap allocations per query, " << size << " vertices (tasks on the sample network)" << endl;
+    cout << left << setw(30) << "Query" << right << setw(16) << "Allocations" << setw(14) << "us/query" << endl;
+    int queries = 2000;
+    for (const Row& row : rows) {
+        for (int q = 0; q < queries; q++) // Warm up
+            row.query((q * 7919) % size, (q * 104729 + 13) % size);
+
+        long before = allocationCount;
+        auto start = chrono::steady_clock::now();
+        for (int q = 0; q < queries; q++)
+            row.query((q * 7919) % size, (q * 104729 + 13) % size);
+        double time = chrono::duration<double, micro>(chrono::steady_clock::now() - start).count() / queries;
+        double allocations = (double)(allocationCount - before) / queries;
+
+        cout << left << setw(30) << row.name << right << setw(16) << fixed << setprecision(2) << allocations
+             << setw(14) << time << endl;
+    }
+    if (checksum == 0)
+        cout << "no results" << endl;
+    cout << endl;
+}
+
+int main() {
+    benchmarkShortestPath();
+    benchmarkBatchThroughput();
+    benchmarkChargingRouter();
+    benchmarkContractionHierarchy();
+    benchmarkLandmarks();
+    benchmarkPriorityQueues();
+    benchmarkIncrementalRepair();
+    benchmarkLoader();
+    benchmarkEngineStartup();
+    benchmarkNameLookup();
+    benchmarkStationTable();
+    benchmarkBatchMode();
+    benchmarkQueryCache();
+    benchmarkQueryAllocations();
+    return 0;
+}
@@ -0,0 +1,333 @@
+//
+//  BenchmarkHarness.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef BenchmarkHarness_h
+#define BenchmarkHarness_h
+
+#include <ctime>
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+
+using namespace std;
+
+// Keep the compiler from optimising away a result that is otherwise unused
+template <class Value>
+inline void doNotOptimize(const Value& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Class definition for BenchmarkState, handed to a benchmark function to drive its timing
+// loop, in the manner of Google Benchmark:
+//     while (state.keepRunning()) { ...code being measured... }
+// The clock starts on the first call and stops when the loop ends; work before the loop is
+// setup and is not timed. pauseTiming and resumeTiming exclude work inside the loop
+class BenchmarkState {
+private:
+    long size;                // The problem size the benchmark runs at
+    long iterations;          // Iterations to run
+    long remaining;
+    bool started;
+    chrono::steady_clock::time_point realStart;
+    clock_t cpuStart;
+    double realSeconds;
+    double cpuSeconds;
+    string skipReason;
+    long itemsProcessed;
+    vector<pair<string, double>> userCounters;
+
+    friend class BenchmarkSuite;
+
+    void startClocks() {
+        realStart = chrono::steady_clock::now();
+        cpuStart = clock();
+    }
+    void stopClocks() {
+        realSeconds += chrono::duration<double>(chrono::steady_clock::now() - realStart).count();
+        cpuSeconds += (double)(clock() - cpuStart) / CLOCKS_PER_SEC;
+    }
+
+public:
+    BenchmarkState(long size, long iterations)
+        : size(size), iterations(iterations), remaining(iterations), started(false), cpuStart(0),
+          realSeconds(0), cpuSeconds(0), itemsProcessed(0) {}
+
+    // Check whether another iteration should run
+    bool keepRunning() {
+        if (!started) {
+            started = true;
+            startClocks();
+        }
+        if (remaining-- > 0)
+            return true;
+        stopClocks();
+        return false;
+    }
+
+    void pauseTiming() {
+        stopClocks();
+    }
+    void resumeTiming() {
+        startClocks();
+    }
+
+    // Get the problem size (the number of locations)
+    long range() const {
+        return size;
+    }
+    long getIterations() const {
+        return iterations;
+    }
+
+    // Give up on this size, for example when the operation is too slow for it. Call before the loop
+    void skip(const string& reason) {
+        skipReason = reason;
+    }
+
+    // Report a throughput: items handled over the whole run
+    void setItemsProcessed(long items) {
+        itemsProcessed = items;
+    }
+    // Report an extra value with the result
+    void counter(const string& name, double value) {
+        userCounters.push_back({ name, value });
+    }
+};
+
+// One measured benchmark, as written to the console and the JSON report
+struct BenchmarkResult {
+    string name;
+    long iterations = 0;
+    double realTime = 0;        // Nanoseconds per iteration
+    double cpuTime = 0;         // Nanoseconds of process CPU time per iteration
+    double itemsPerSecond = 0;
+    string skipped;             // Why the benchmark did not run (empty if it did)
+    vector<pair<string, double>> counters;
+};
+
+// Options of a benchmark run, set from the command line
+struct BenchmarkOptions {
+    string filter;               // Only run benchmarks whose name contains this
+    double minTime = 0.2;        // Seconds each benchmark runs for at least
+    string outFile;              // Write the JSON report here (empty: none)
+    bool jsonToConsole = false;  // Print the JSON report instead of the table
+};
+
+// Class definition for BenchmarkSuite, a list of benchmark functions run at a list of sizes.
+// Each benchmark first runs one iteration; if that took less than the minimum time, it runs
+// again with the number of iterations scaled up to fill the minimum time. Results go to a
+// table on the console and, as Google Benchmark's JSON format, to a file for tracking over time
+class BenchmarkSuite {
+private:
+    struct Benchmark {
+        string name;
+        function<void(BenchmarkState&)> run;
+    };
+
+    vector<Benchmark> benchmarks;
+    vector<BenchmarkResult> results;
+
+    // Run one benchmark at one size until it has taken the minimum time
+    BenchmarkResult measure(const Benchmark& benchmark, long size, double minTime);
+    void printHeader() const;
+    void printResult(const BenchmarkResult& result) const;
+    string json() const;
+
+public:
+    // Add a benchmark; it is run at every size, as name/size
+    void add(const string& name, function<void(BenchmarkState&)> run) {
+        benchmarks.push_back({ name, run });
+    }
+
+    // Run every benchmark matching the filter at every size, sizes in the outer loop so the
+    // setup of one size can be shared by its benchmarks. Returns false if the report cannot be written
+    bool run(const vector<long>& sizes, const BenchmarkOptions& options);
+
+    // Parse --benchmark_filter=, --benchmark_min_time=, --benchmark_out=, --benchmark_format=json
+    // and --sizes=a,b,c. Returns false on an unknown argument
+    static bool parseArguments(int argc, char* argv[], BenchmarkOptions& options, vector<long>& sizes);
+};
+
+
+// Function to measure one benchmark
+BenchmarkResult BenchmarkSuite::measure(const Benchmark& benchmark, long size, double minTime) {
+    BenchmarkResult result;
+    result.name = benchmark.name + "/" + to_string(size);
+
+    long iterations = 1;
+    while (true) {
+        BenchmarkState state(size, iterations);
+        benchmark.run(state);
+        if (!state.skipReason.empty()) {
+            result.skipped = state.skipReason;
+            return result;
+        }
+
+        // Stop when the run was long enough, otherwise predict the count that fills the minimum time
+        if (state.realSeconds >= minTime || iterations >= 1000000000) {
+            result.iterations = iterations;
+            result.realTime = state.realSeconds * 1e9 / iterations;
+            result.cpuTime = state.cpuSeconds * 1e9 / iterations;
+            if (state.itemsProcessed > 0)
+                result.itemsPerSecond = state.itemsProcessed / state.realSeconds;
+            result.counters = state.userCounters;
+            return result;
+        }
+        double scale = state.realSeconds > 0 ? 1.4 * minTime / state.realSeconds : 100;
+        iterations = (long)min(1e9, max(iterations * 2.0, min(iterations * scale, iterations * 100.0)));
+    }
+}
+
+
+// Function to print the column headings
+void BenchmarkSuite::printHeader() const {
+    cout << left << setw(56) << "Benchmark" << right << setw(16) << "Time" << setw(16) << "CPU" << setw(12) << "Iterations"
+         << " UserCounters..." << endl;
+    cout << string(112, '-') << endl;
+}
+
+
+// Function to print one result line
+void BenchmarkSuite::printResult(const BenchmarkResult& result) const {
+    cout << left << setw(56) << result.name << right;
+    if (!result.skipped.empty()) {
+        cout << " SKIPPED: " << result.skipped << endl;
+        return;
+    }
+    cout << setw(13) << fixed << setprecision(result.realTime < 100 ? 2 : 0) << result.realTime << " ns"
+         << setw(13) << setprecision(result.cpuTime < 100 ? 2 : 0) << result.cpuTime << " ns" << setw(12) << result.iterations;
+    if (result.itemsPerSecond > 0)
+        cout << " items_per_second=" << setprecision(0) << result.itemsPerSecond;
+    for (const pair<string, double>& counter : result.counters)
+        cout << " " << counter.first << "=" << setprecision(2) << counter.second;
+    cout << endl;
+}
+
+
+// Function to write the results in Google Benchmark's JSON format
+string BenchmarkSuite::json() const {
+    char hostName[256] = "unknown";
+    gethostname(hostName, sizeof(hostName) - 1);
+    time_t now = time(nullptr);
+    char date[64];
+    strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+    string out = "{\n  \"context\": {\n";
+    out += "    \"date\": \"" + string(date) + "\",\n";
+    out += "    \"host_name\": \"" + string(hostName) + "\",\n";
+    out += "    \"num_cpus\": " + to_string(sysconf(_SC_NPROCESSORS_ONLN)) + ",\n";
+#ifdef NDEBUG
+    out += "    \"library_build_type\": \"release\"\n";
+#else
+    out += "    \"library_build_type\": \"debug\"\n";
+#endif
+    out += "  },\n  \"benchmarks\": [";
+
+    char number[64];
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchmarkResult& result = results[i];
+        out += i == 0 ? "\n" : ",\n";
+        out += "    {\n      \"name\": \"" + result.name + "\",\n";
+        out += "      \"run_name\": \"" + result.name + "\",\n";
+        out += "      \"run_type\": \"iteration\",\n";
+        if (!result.skipped.empty()) {
+            out += "      \"error_occurred\": true,\n";
+            out += "      \"error_message\": \"" + result.skipped + "\"\n    }";
+            continue;
+        }
+        out += "      \"iterations\": " + to_string(result.iterations) + ",\n";
+        snprintf(number, sizeof(number), "%.6g", result.realTime);
+        out += "      \"real_time\": " + string(number) + ",\n";
+        snprintf(number, sizeof(number), "%.6g", result.cpuTime);
+        out += "      \"cpu_time\": " + string(number) + ",\n";
+        if (result.itemsPerSecond > 0) {
+            snprintf(number, sizeof(number), "%.6g", result.itemsPerSecond);
+            out += "      \"items_per_second\": " + string(number) + ",\n";
+        }
+        for (const pair<string, double>& counter : result.counters) {
+            snprintf(number, sizeof(number), "%.6g", counter.second);
+            out += "      \"" + counter.first + "\": " + string(number) + ",\n";
+        }
+        out += "      \"time_unit\": \"ns\"\n    }";
+    }
+    out += "\n  ]\n}\n";
+    return out;
+}
+
+
+// Function to run the suite
+bool BenchmarkSuite::run(const vector<long>& sizes, const BenchmarkOptions& options) {
+    if (!options.jsonToConsole)
+        printHeader();
+
+    for (long size : sizes) {
+        for (const Benchmark& benchmark : benchmarks) {
+            if (!options.filter.empty() && (benchmark.name + "/" + to_string(size)).find(options.filter) == string::npos)
+                continue;
+            results.push_back(measure(benchmark, size, options.minTime));
+            if (!options.jsonToConsole)
+                printResult(results.back());
+        }
+    }
+
+    if (options.jsonToConsole)
+        cout << json();
+    if (!options.outFile.empty()) {
+        FILE* file = fopen(options.outFile.c_str(), "w");
+        if (file == nullptr) {
+            cout << "Cannot open output file." << endl;
+            return false;
+        }
+        string report = json();
+        fwrite(report.data(), 1, report.size(), file);
+        fclose(file);
+    }
+    return true;
+}
+
+
+// Function to read the command line
+bool BenchmarkSuite::parseArguments(int argc, char* argv[], BenchmarkOptions& options, vector<long>& sizes) {
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        string key = argument.substr(0, equals);
+        string value = equals == string::npos ? "" : argument.substr(equals + 1);
+
+        if (key == "--benchmark_filter") {
+            options.filter = value;
+        } else if (key == "--benchmark_min_time") {
+            options.minTime = atof(value.c_str());
+        } else if (key == "--benchmark_out") {
+            options.outFile = value;
+        } else if (key == "--benchmark_format") {
+            options.jsonToConsole = value == "json";
+        } else if (key == "--sizes") {
+            sizes.clear();
+            for (size_t start = 0; start < value.size();) {
+                size_t comma = value.find(',', start);
+                if (comma == string::npos)
+                    comma = value.size();
+                sizes.push_back(atol(value.substr(start, comma - start).c_str()));
+                start = comma + 1;
+            }
+        } else {
+            cout << "Unknown argument: " << argument << endl;
+            cout << "Usage: " << argv[0] << " [--sizes=100,10000,1000000] [--benchmark_filter=text] [--benchmark_min_time=seconds]"
+                 << " [--benchmark_out=file.json] [--benchmark_format=json]" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+#endif /* BenchmarkHarness_h */
@@ -0,0 +1,81 @@
+//
+//  ChargingAmount.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef ChargingAmount_h
+#define ChargingAmount_h
+
+#include <cstdint>
+#include <atomic>
+
+using namespace std;
+
+// Class definition for ChargingAmount, the source of made-up charging amounts (10 to 50 kWh)
+// for the interactive tasks and for simulated query streams. Amounts come from a splitmix64
+// sequence seeded by one global seed, so a run can be replayed exactly.
+// next() draws from a generator owned by the calling thread, so threads never share state.
+// forKey() is stateless: the amount depends only on the seed and the key (such as a query's
+// line number), so it is the same whichever thread or in whatever order it is asked for
+class ChargingAmount {
+private:
+    static atomic<uint64_t> seedValue;       // Seed of every sequence
+    static atomic<uint64_t> seedGeneration;  // Incremented by setSeed, so threads restart their sequence
+    static atomic<uint64_t> threadCount;     // Threads that have drawn so far, for per-thread streams
+
+    static const uint64_t golden = 0x9e3779b97f4a7c15ull;
+
+    // splitmix64 finaliser: spreads every input bit over the whole output
+    static uint64_t mix(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    // Map random bits to an amount in [minimum, maximum]
+    static int fromBits(uint64_t bits) {
+        return minimum + (int)(bits % (uint64_t)(maximum - minimum + 1));
+    }
+
+public:
+    static const int minimum = 10; // Smallest amount in kWh
+    static const int maximum = 50; // Largest amount in kWh
+
+    // Restart every sequence from a new seed
+    static void setSeed(uint64_t seed) {
+        seedValue = seed;
+        seedGeneration++;
+    }
+
+    static uint64_t seed() {
+        return seedValue;
+    }
+
+    // Draw the next amount of the calling thread's sequence. The first thread to draw gets
+    // stream 0, the next stream 1 and so on, so a single-threaded run is reproducible
+    static int next() {
+        static thread_local uint64_t generation = ~(uint64_t)0;
+        static thread_local uint64_t stream = threadCount++;
+        static thread_local uint64_t state = 0;
+
+        if (generation != seedGeneration) {
+            generation = seedGeneration;
+            state = mix(seedValue + stream * golden);
+        }
+        state += golden;
+        return fromBits(mix(state));
+    }
+
+    // Get the amount belonging to a key under the current seed
+    static int forKey(uint64_t key) {
+        return fromBits(mix(mix(seedValue) + key * golden));
+    }
+};
+
+atomic<uint64_t> ChargingAmount::seedValue(1);
+atomic<uint64_t> ChargingAmount::seedGeneration(0);
+atomic<uint64_t> ChargingAmount::threadCount(0);
+
+#endif /* ChargingAmount_h */
@@ -0,0 +1,252 @@
+//
+//  ChargingRouter.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef ChargingRouter_h
+#define ChargingRouter_h
+
+#include <cfloat>
+#include <cmath>
+#include <vector>
+
+#include "WeightedGraph.h"
+
+// Battery and charging parameters of the vehicle being routed
+struct BatteryProfile {
+    double capacity = 40;          // Usable battery capacity in kWh
+    double initialCharge = 20;     // Charge at the origin in kWh
+    double consumption = 0.2;      // Energy used per km driven, in kWh
+    double chargeStep = 1;         // State of charge is tracked in steps of this many kWh
+    double freeChargingLimit = 25; // Most kWh a free station gives per stop
+};
+
+// One charging stop of a plan
+struct ChargingStop {
+    int location;  // Where the vehicle charges
+    double amount; // kWh charged
+    double cost;   // Cost of the charge in dollars
+};
+
+// Result of ChargingRouter::plan
+struct ChargingPlan {
+    bool found = false;          // False if the destination cannot be reached on this battery
+    double travelCost = 0;       // Driving cost in dollars
+    double chargingCost = 0;     // Sum of the costs of the stops
+    double arrivalCharge = 0;    // Battery charge left at the destination, in kWh
+    vector<int> path;            // Locations visited, origin first
+    vector<ChargingStop> stops;  // Charging stops in the order they are made
+};
+
+// Class definition for ChargingRouter, a resource-constrained shortest path engine.
+// A label is a way of reaching a location with a given (discretised) state of charge at a
+// given cost. Labels are expanded from a bucketed queue in order of their cost plus a lower
+// bound of the cost still to come (as in A*), and a label is dropped as soon as another label
+// at the same location has at least as much charge for at most the same cost (Pareto
+// dominance). Any number of charging stops is allowed
+class ChargingRouter {
+private:
+    // A partial route: where it is, how much charge is left, what it cost and how it got there
+    struct Label {
+        int location;       // Current location
+        int level;          // State of charge in steps of BatteryProfile::chargeStep
+        double cost;        // Travel plus charging cost so far
+        double kilometres;  // Distance driven so far
+        int parent;         // Label this one was extended from (-1 for the start)
+        int charged;        // Steps charged to create this label (0 for a driving label)
+        bool dominated;     // Set when a better label at the same location turns up
+    };
+
+    WeightedGraphType& graph;
+    const vector<bool>& chargerInstalled; // Charger flag of every location
+    const vector<double>& chargingPrice;  // Price per kWh of every location
+    double travelCostPerKm;
+
+    vector<Label> labels;                 // Every label created by the current search
+    vector<vector<int>> locationLabels;   // Non-dominated labels at each location
+    vector<vector<int>> buckets;          // Queue: bucket b holds labels whose cost plus bound is [b, b + 1) cents
+    size_t currentBucket;                 // Bucket being expanded
+
+    // Distance of every location to the destination, from one search backwards over the roads,
+    // and the lower bound it gives (see remainingCost)
+    ShortestPathTree toDestination;
+    DijkstraWorkspace workspace;
+    double cheapestPrice;                 // Lowest price per kWh of any charger
+    double consumption;                   // kWh per km of the battery being planned for
+    double chargeStep;
+
+    // Get a lower bound of the cost from a label to the destination: driving the rest of the
+    // shortest road distance, and buying the energy it needs beyond the charge left at the
+    // cheapest price. Driving a road or charging never lowers cost + bound, so labels come out
+    // of the queue in order of it and the first plan found at a given bound is the cheapest
+    double remainingCost(const Label& label) const {
+        double distance = toDestination.distance[label.location];
+        double missing = max(0.0, distance * consumption - label.level * chargeStep);
+        return distance * travelCostPerKm + missing * cheapestPrice;
+    }
+
+    // Check whether label a makes label b pointless. A label created by charging cannot
+    // charge again at the same stop, so it never dominates one that still can
+    bool dominates(const Label& a, const Label& b) const {
+        return a.level >= b.level && a.cost <= b.cost && (a.charged == 0 || b.charged != 0);
+    }
+
+    // Add a label unless it is dominated or cannot reach the destination, retiring any labels it dominates
+    void addLabel(const Label& label);
+
+public:
+    ChargingRouter(WeightedGraphType& graph, const vector<bool>& chargerInstalled, const vector<double>& chargingPrice, double travelCostPerKm = 0.1)
+        : graph(graph), chargerInstalled(chargerInstalled), chargingPrice(chargingPrice), travelCostPerKm(travelCostPerKm) {}
+
+    // Find the cheapest route from origin to destination for the given battery
+    ChargingPlan plan(int origin, int destination, const BatteryProfile& battery);
+};
+
+
+// Function to add a label to its location's Pareto set and to the queue
+void ChargingRouter::addLabel(const Label& label) {
+    if (!toDestination.reachable(label.location))
+        return;
+    vector<int>& here = locationLabels[label.location];
+
+    for (int id : here)
+        if (dominates(labels[id], label))
+            return;
+
+    // Retire the labels the new one dominates; they stay in the queue but are skipped
+    int kept = 0;
+    for (int id : here) {
+        if (dominates(label, labels[id]))
+            labels[id].dominated = true;
+        else
+            here[kept++] = id;
+    }
+    here.resize(kept);
+
+    int id = (int)labels.size();
+    labels.push_back(label);
+    here.push_back(id);
+
+    // Cost plus bound never drops along a route, but rounding can take it a hair below the
+    // bucket being expanded, which must not send the label to a bucket already passed
+    size_t bucket = max(currentBucket, (size_t)((label.cost + remainingCost(label)) * 100));
+    if (bucket >= buckets.size())
+        buckets.resize(bucket + 1);
+    buckets[bucket].push_back(id);
+}
+
+
+// Function to find the cheapest route under the battery constraint
+// Buckets are one cent wide, so labels are taken in order of cost plus bound to within a cent.
+// Labels are never finalised on being popped; instead the search runs until the current bucket
+// costs more than the best plan found, which keeps the result exact. The bound keeps the search
+// from spreading away from the destination, and locations that cannot reach it are never entered
+ChargingPlan ChargingRouter::plan(int origin, int destination, const BatteryProfile& battery) {
+    EV_TIMER_LEG("ChargingRouter::plan", origin, destination);
+    SearchCounters counters;
+    ChargingPlan result;
+    int maxLevel = (int)floor(battery.capacity / battery.chargeStep + 1e-9);
+    int freeLevels = (int)floor(battery.freeChargingLimit / battery.chargeStep + 1e-9);
+
+    labels.clear();
+    buckets.clear();
+    currentBucket = 0;
+    locationLabels.assign(graph.getNumberOfVertices(), vector<int>());
+
+    graph.reverseShortestPathTree(destination, toDestination, workspace);
+    consumption = battery.consumption;
+    chargeStep = battery.chargeStep;
+    cheapestPrice = DBL_MAX;
+    for (int v = 0; v < graph.getNumberOfVertices(); v++)
+        if (chargerInstalled[v])
+            cheapestPrice = min(cheapestPrice, chargingPrice[v]);
+    if (cheapestPrice == DBL_MAX)
+        cheapestPrice = 0;
+
+    Label start = {origin, min(maxLevel, (int)floor(battery.initialCharge / battery.chargeStep + 1e-9)), 0, 0, -1, 0, false};
+    addLabel(start);
+
+    int best = -1;
+    for (size_t bucket = 0; bucket < buckets.size(); bucket++) {
+        currentBucket = bucket;
+        // Nothing cheaper than the best plan can come out of this or any later bucket
+        if (best != -1 && bucket > (size_t)(labels[best].cost * 100))
+            break;
+
+        // Labels added to this bucket while it is being processed are picked up as well
+        for (size_t k = 0; k < buckets[bucket].size(); k++) {
+            int id = buckets[bucket][k];
+            counters.pops++;
+            if (labels[id].dominated)
+                continue;
+            counters.settled++;
+            Label current = labels[id]; // Copy: labels may reallocate below
+
+            if (current.location == destination) {
+                if (best == -1 || current.cost < labels[best].cost)
+                    best = id;
+                continue;
+            }
+
+            // Drive along every open road the remaining charge covers. The energy needed is
+            // rounded up to whole steps, so the plan never relies on rounding in its favour
+            counters.relaxed += graph.edgeEnd(current.location) - graph.edgeBegin(current.location);
+            for (int e = graph.edgeBegin(current.location); e < graph.edgeEnd(current.location); e++) {
+                double length = graph.edgeWeight(e);
+                if (length == DBL_MAX)
+                    continue; // Closed road
+                int needed = (int)ceil(length * battery.consumption / battery.chargeStep - 1e-9);
+                if (needed > current.level)
+                    continue;
+
+                Label next = {graph.edgeTarget(e), current.level - needed, current.cost + length * travelCostPerKm,
+                              current.kilometres + length, id, 0, false};
+                addLabel(next);
+            }
+
+            // Charge by every possible amount at a station, unless this label just charged here
+            int v = current.location;
+            if (chargerInstalled[v] && current.charged == 0) {
+                double price = chargingPrice[v];
+                int most = maxLevel - current.level;
+                if (price == 0)
+                    most = min(most, freeLevels);
+
+                for (int steps = 1; steps <= most; steps++) {
+                    Label next = {v, current.level + steps, current.cost + steps * battery.chargeStep * price,
+                                  current.kilometres, id, steps, false};
+                    addLabel(next);
+                }
+            }
+        }
+    }
+    counters.pushes = labels.size();
+
+    if (best == -1)
+        return result;
+
+    // Walk the parent labels back to the start to recover the route and its stops
+    result.found = true;
+    result.arrivalCharge = labels[best].level * battery.chargeStep;
+    result.travelCost = labels[best].kilometres * travelCostPerKm;
+
+    for (int id = best; id != -1; id = labels[id].parent) {
+        const Label& label = labels[id];
+        if (label.charged > 0) {
+            double amount = label.charged * battery.chargeStep;
+            ChargingStop stop = {label.location, amount, amount * chargingPrice[label.location]};
+            result.stops.push_back(stop);
+            result.chargingCost += stop.cost;
+        } else {
+            result.path.push_back(label.location);
+        }
+    }
+    reverse(result.path.begin(), result.path.end());
+    reverse(result.stops.begin(), result.stops.end());
+
+    return result;
+}
+
+#endif /* ChargingRouter_h */
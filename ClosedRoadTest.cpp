@@ -0,0 +1,83 @@
+//
+//  ClosedRoadTest.cpp
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+//  Build: cmake -S . -B build && cmake --build build
+//  Run:   ctest --test-dir build (or ./build/ClosedRoadTest)
+//
+//  Checks that the queries never use a road closed while the program runs, on a tiny network
+//  and on the sample network. Exits with 1 if any query does
+//
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cfloat>
+
+using namespace std;
+
+#include "EVCharging.h"
+
+// Report one check, returning 1 if it failed
+int check(const char* name, bool passed) {
+    cout << name << (passed ? "" : "  FAILED") << endl;
+    return passed ? 0 : 1;
+}
+
+// Plan a trip on three locations without chargers: a 10 km road from Start to End, and a
+// detour of two 10 km roads through Middle. The battery covers 10 km, so once the direct
+// road is closed the detour is out of reach and no plan may be found
+int checkMultiStopTrip() {
+    const string locationsFile = "ClosedRoadLocations.txt", weightsFile = "ClosedRoadWeights.txt";
+    ofstream(locationsFile) << "Start,0,-1\nEnd,0,-1\nMiddle,0,-1\n";
+    ofstream(weightsFile) << "0 1 10\n1 0 10\n0 2 10\n2 0 10\n2 1 10\n1 2 10\n";
+
+    int failures = 0;
+    {
+        EVCharging charging(locationsFile, weightsFile, EDGE_LIST);
+        Query trip;
+        trip.task = 11;
+        trip.origin = 0;
+        trip.destination = 1;
+        trip.chargingAmount = 2;
+
+        QueryResult planned = charging.answer(trip);
+        failures += check("Multi-stop trip over an open road", planned.found && planned.path == vector<int>({0, 1}));
+        charging.updateRoadDistance(0, 1, DBL_MAX);
+        failures += check("Multi-stop trip over a closed road", !charging.answer(trip).found);
+    }
+
+    for (const string& file : {locationsFile, weightsFile, weightsFile + ".dist", weightsFile + ".snap", weightsFile + ".ch"})
+        remove(file.c_str());
+    return failures;
+}
+
+// Close the road from Penrith to station 21 of the sample network: tasks 4 and 5 for Penrith
+// must no longer offer that station
+int checkAdjacentStations() {
+    EVCharging charging;
+    if (charging.getNumberOfLocations() <= 21) {
+        cout << "Cannot load the sample network." << endl;
+        return 1;
+    }
+    auto offers = [](const QueryResult& result, int station) {
+        return find(result.stations.begin(), result.stations.end(), station) != result.stations.end();
+    };
+
+    int failures = check("Adjacent stations over an open road", offers(charging.answer({4, 0}), 21));
+    charging.updateRoadDistance(0, 21, DBL_MAX);
+    failures += check("Adjacent stations over a closed road", !offers(charging.answer({4, 0}), 21));
+    for (int amount : {10, 30})
+        failures += check("Cheapest adjacent station over a closed road", !offers(charging.answer({5, 0, -1, amount}), 21));
+    return failures;
+}
+
+int main() {
+    int failures = checkMultiStopTrip() + checkAdjacentStations();
+    return failures == 0 ? 0 : 1;
+}
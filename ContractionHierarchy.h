@@ -0,0 +1,579 @@
+//
+//  ContractionHierarchy.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef ContractionHierarchy_h
+#define ContractionHierarchy_h
+
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <stack>
+#include <queue>
+#include <atomic>
+#include <algorithm>
+
+#include "MappedFile.h"
+#include "WeightedGraph.h"
+
+// On-disk layout of a saved contraction hierarchy (every block starts 8-byte aligned):
+//   HierarchyHeader
+//   Edge edges[edgeCount]                       (original edges followed by shortcuts)
+//   int32_t rank[vertexCount]
+//   int32_t upwardOutOffsets[vertexCount + 1]
+//   int32_t upwardOutEdges[upwardOutCount]
+//   int32_t upwardInOffsets[vertexCount + 1]
+//   int32_t upwardInEdges[upwardInCount]
+struct HierarchyHeader {
+    char magic[8];             // "EVHIER1" followed by a zero byte
+    uint32_t vertexCount;      // Number of vertices in the graph
+    uint32_t shortcutCount;    // Number of shortcut edges
+    uint64_t edgeCount;        // Number of edges including the shortcuts
+    uint64_t upwardOutCount;   // Number of edges in the forward upward graph
+    uint64_t upwardInCount;    // Number of edges in the backward upward graph
+    uint64_t weightsChecksum;  // FNV-1a checksum of the weights file the hierarchy was built from
+};
+
+// Class definition for ContractionHierarchy, a preprocessed form of a WeightedGraphType for
+// fast point-to-point queries. Vertices are contracted one at a time, least important first;
+// contracting v adds a shortcut u -> w for every path u -> v -> w that is the only shortest
+// way from u to w. A query then only needs to search upwards (towards vertices contracted
+// later) from both ends, which settles a small fraction of the graph
+class ContractionHierarchy {
+private:
+    // An original edge or a shortcut. A shortcut stands for its two child edges in sequence
+    struct Edge {
+        int from;
+        int to;
+        double weight;
+        int firstChild;  // from -> middle (-1 for an original edge)
+        int secondChild; // middle -> to (-1 for an original edge)
+    };
+
+    int gSize;              // Number of vertices
+    vector<Edge> edges;     // Original edges followed by shortcuts
+    vector<int> rank;       // Position of every vertex in the contraction order
+    int shortcuts;          // Number of shortcut edges added
+
+    // Upward search graphs in CSR form, holding edge ids.
+    // upwardOut[v]: edges v -> w with rank[w] > rank[v] (forward search)
+    // upwardIn[v]:  edges u -> v with rank[u] > rank[v] (backward search, followed in reverse)
+    vector<int> upwardOutOffsets, upwardOutEdges;
+    vector<int> upwardInOffsets, upwardInEdges;
+
+    // Per-direction search state for a query
+    struct SearchSide {
+        DijkstraWorkspace workspace; // Stamped distances and the heap
+        vector<int> parentEdge;      // Edge used to reach each vertex (valid where the distance is)
+    };
+
+    // Build the contraction order and the shortcuts, stopping early once cancel is set
+    void contract(int witnessSettleLimit, const atomic<bool>* cancel);
+    // Turn the edge list into the two upward CSR graphs
+    void buildUpwardGraphs();
+    // Append the original vertices along an edge (excluding its tail) to a path
+    void unpackEdge(int edge, vector<int>& path) const;
+
+    static constexpr const char* magicString = "EVHIER1";
+    static const int blockCount = 6;
+
+    // Empty hierarchy, filled in by read
+    ContractionHierarchy() : gSize(0), shortcuts(0) {}
+
+    // Round a byte count up to the next multiple of 8
+    static size_t aligned(size_t bytes) {
+        return (bytes + 7) & ~(size_t)7;
+    }
+
+    // Size in bytes of every block, in file order
+    static void blockSizes(const HierarchyHeader& header, size_t sizes[blockCount]) {
+        sizes[0] = aligned(header.edgeCount * sizeof(Edge));
+        sizes[1] = aligned(header.vertexCount * sizeof(int32_t));
+        sizes[2] = aligned(((size_t)header.vertexCount + 1) * sizeof(int32_t));
+        sizes[3] = aligned(header.upwardOutCount * sizeof(int32_t));
+        sizes[4] = aligned(((size_t)header.vertexCount + 1) * sizeof(int32_t));
+        sizes[5] = aligned(header.upwardInCount * sizeof(int32_t));
+    }
+
+public:
+    // Preprocess the graph. A higher witness settle limit spends more preprocessing time
+    // on proving shortcuts unnecessary, giving fewer shortcuts. Setting *cancel from another
+    // thread stops preprocessing early; the unfinished hierarchy must not be queried
+    ContractionHierarchy(WeightedGraphType& graph, int witnessSettleLimit = 500, const atomic<bool>* cancel = nullptr);
+
+    // Write the hierarchy to fileName, so later runs load it instead of contracting the graph
+    // again. Returns false if the file cannot be written
+    bool write(const char* fileName, uint64_t weightsChecksum) const;
+
+    // Load a hierarchy written by write. Returns nullptr if the file is missing, damaged, or
+    // was built for a different number of vertices or from a different weights file (stale)
+    static ContractionHierarchy* read(const char* fileName, int vertices, uint64_t weightsChecksum);
+
+    // Get the number of shortcut edges added by preprocessing
+    int getShortcutCount() const {
+        return shortcuts;
+    }
+
+    // Find the smallest weight from origin to destination (DBL_MAX if unreachable)
+    double distance(int origin, int destination) {
+        static thread_local vector<int> path;
+        return shortestPath(origin, destination, path);
+    }
+
+    // Find the shortest path from origin to destination as original vertices, origin first.
+    // Returns its weight, or DBL_MAX (and an empty path) if the destination is unreachable
+    double shortestPath(int origin, int destination, vector<int>& path);
+
+    // Same as above in the form of WeightedGraphType::shortestPath(origin, destination):
+    // origin on top of the stack, or only the destination if it is unreachable
+    stack<int> shortestPath(int origin, int destination);
+};
+
+
+// Constructor for ContractionHierarchy class
+ContractionHierarchy::ContractionHierarchy(WeightedGraphType& graph, int witnessSettleLimit, const atomic<bool>* cancel) {
+    gSize = graph.getNumberOfVertices();
+    shortcuts = 0;
+
+    // Start from the original edges
+    for (int v = 0; v < gSize; v++)
+        for (int e = graph.edgeBegin(v); e < graph.edgeEnd(v); e++) {
+            Edge edge = {v, graph.edgeTarget(e), graph.edgeWeight(e), -1, -1};
+            edges.push_back(edge);
+        }
+
+    contract(witnessSettleLimit, cancel);
+    buildUpwardGraphs();
+}
+
+
+// Function to contract every vertex and add the shortcuts
+// Vertices are ordered by edge difference (shortcuts added minus edges removed) plus the
+// number of already contracted neighbours, which spreads contraction evenly over the graph.
+// Priorities are updated lazily: a popped vertex is re-evaluated and pushed back if it is
+// no longer the best choice
+void ContractionHierarchy::contract(int witnessSettleLimit, const atomic<bool>* cancel) {
+    vector<vector<int>> outEdges(gSize), inEdges(gSize); // Edge ids touching each uncontracted vertex
+    vector<int> contractedNeighbours(gSize, 0);
+    DijkstraWorkspace witness;
+
+    for (int id = 0; id < (int)edges.size(); id++) {
+        outEdges[edges[id].from].push_back(id);
+        inEdges[edges[id].to].push_back(id);
+    }
+
+    // Witness search from source over the uncontracted graph without `skip`, stopping
+    // once weights pass limit or witnessSettleLimit vertices are settled. Afterwards
+    // witness.distanceOf(w) is an upper bound on the distance from source to w that
+    // avoids skip; when the search was cut short, missing witnesses only add shortcuts
+    auto witnessSearch = [&](int source, int skip, double limit) {
+        vector<pair<double, int>>& heap = witness.heap;
+        greater<pair<double, int>> later;
+        witness.newSearch(gSize);
+        witness.setDistance(source, 0);
+        heap.push_back(make_pair(0.0, source));
+
+        for (int settled = 0; !heap.empty() && settled < witnessSettleLimit; settled++) {
+            pop_heap(heap.begin(), heap.end(), later);
+            double weight = heap.back().first;
+            int v = heap.back().second;
+            heap.pop_back();
+
+            if (weight > witness.distanceOf(v))
+                continue;
+            if (weight > limit)
+                return;
+
+            for (int id : outEdges[v]) {
+                int w = edges[id].to;
+                if (w == skip)
+                    continue;
+                double next = weight + edges[id].weight;
+                if (next < witness.distanceOf(w)) {
+                    witness.setDistance(w, next);
+                    heap.push_back(make_pair(next, w));
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+    };
+
+    // Contract v, or (if simulate is set) only count the shortcuts contracting it would add.
+    // One witness search per in-neighbour u covers every out-neighbour w
+    auto contractVertex = [&](int v, bool simulate) {
+        int added = 0;
+        double longestOut = 0;
+        for (int out : outEdges[v])
+            longestOut = max(longestOut, edges[out].weight);
+
+        for (size_t i = 0; i < inEdges[v].size(); i++) {
+            int in = inEdges[v][i];
+            int u = edges[in].from;
+            if (u == v)
+                continue;
+
+            witnessSearch(u, v, edges[in].weight + longestOut);
+
+            for (size_t k = 0; k < outEdges[v].size(); k++) {
+                int out = outEdges[v][k];
+                int w = edges[out].to;
+                if (w == v || w == u)
+                    continue;
+
+                double weight = edges[in].weight + edges[out].weight;
+                if (witness.distanceOf(w) <= weight)
+                    continue;
+
+                added++;
+                if (!simulate) {
+                    Edge shortcut = {u, w, weight, in, out};
+                    edges.push_back(shortcut);
+                    outEdges[u].push_back((int)edges.size() - 1);
+                    inEdges[w].push_back((int)edges.size() - 1);
+                    shortcuts++;
+                }
+            }
+        }
+        return added;
+    };
+
+    // Remove the edges of a contracted vertex from its neighbours' lists,
+    // so later searches and counts only see the remaining graph
+    auto detach = [&](int v) {
+        for (int in : inEdges[v]) {
+            vector<int>& list = outEdges[edges[in].from];
+            list.erase(remove(list.begin(), list.end(), in), list.end());
+        }
+        for (int out : outEdges[v]) {
+            vector<int>& list = inEdges[edges[out].to];
+            list.erase(remove(list.begin(), list.end(), out), list.end());
+        }
+    };
+
+    // Priority of a vertex: lower is contracted sooner
+    auto priority = [&](int v) {
+        int removed = (int)(inEdges[v].size() + outEdges[v].size());
+        return contractVertex(v, true) - removed + contractedNeighbours[v];
+    };
+
+    priority_queue<pair<int, int>, vector<pair<int, int>>, greater<pair<int, int>>> order;
+    for (int v = 0; v < gSize; v++)
+        order.push(make_pair(priority(v), v));
+
+    rank.assign(gSize, 0);
+    int nextRank = 0;
+
+    while (!order.empty()) {
+        if (cancel != nullptr && *cancel)
+            return;
+        int v = order.top().second;
+        order.pop();
+
+        // Re-evaluate lazily; if v has become worse than the next candidate, try again later
+        int current = priority(v);
+        if (!order.empty() && current > order.top().first) {
+            order.push(make_pair(current, v));
+            continue;
+        }
+
+        contractVertex(v, false);
+        rank[v] = nextRank++;
+
+        for (int in : inEdges[v])
+            contractedNeighbours[edges[in].from]++;
+        for (int out : outEdges[v])
+            contractedNeighbours[edges[out].to]++;
+        detach(v);
+    }
+}
+
+
+// Function to build the upward CSR graphs from the edge list
+// Every edge goes from a lower to a higher rank in exactly one direction, so it lands in
+// exactly one of the two graphs
+void ContractionHierarchy::buildUpwardGraphs() {
+    upwardOutOffsets.assign(gSize + 1, 0);
+    upwardInOffsets.assign(gSize + 1, 0);
+
+    for (const Edge& edge : edges) {
+        if (rank[edge.to] > rank[edge.from])
+            upwardOutOffsets[edge.from + 1]++;
+        else
+            upwardInOffsets[edge.to + 1]++;
+    }
+    for (int v = 0; v < gSize; v++) {
+        upwardOutOffsets[v + 1] += upwardOutOffsets[v];
+        upwardInOffsets[v + 1] += upwardInOffsets[v];
+    }
+
+    upwardOutEdges.resize(upwardOutOffsets[gSize]);
+    upwardInEdges.resize(upwardInOffsets[gSize]);
+    vector<int> nextOut(upwardOutOffsets.begin(), upwardOutOffsets.end() - 1);
+    vector<int> nextIn(upwardInOffsets.begin(), upwardInOffsets.end() - 1);
+
+    for (int id = 0; id < (int)edges.size(); id++) {
+        const Edge& edge = edges[id];
+        if (rank[edge.to] > rank[edge.from])
+            upwardOutEdges[nextOut[edge.from]++] = id;
+        else
+            upwardInEdges[nextIn[edge.to]++] = id;
+    }
+}
+
+
+// Function to write the hierarchy
+// The file is written under a temporary name and renamed when complete
+bool ContractionHierarchy::write(const char* fileName, uint64_t weightsChecksum) const {
+    string tempFileName = string(fileName) + ".tmp";
+
+    // Fill in the header
+    HierarchyHeader header;
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, magicString);
+    header.vertexCount = gSize;
+    header.shortcutCount = shortcuts;
+    header.edgeCount = edges.size();
+    header.upwardOutCount = upwardOutEdges.size();
+    header.upwardInCount = upwardInEdges.size();
+    header.weightsChecksum = weightsChecksum;
+
+    size_t sizes[blockCount];
+    blockSizes(header, sizes);
+    size_t total = sizeof(header);
+    for (size_t size : sizes)
+        total += size;
+
+    MappedFile output;
+    if (!output.create(tempFileName.c_str(), total)) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+
+    // Lay the blocks out one after another; the new file is zero-filled, so padding needs no writes
+    char* block[blockCount];
+    block[0] = output.data() + sizeof(header);
+    for (int b = 1; b < blockCount; b++)
+        block[b] = block[b - 1] + sizes[b - 1];
+
+    memcpy(output.data(), &header, sizeof(header));
+    memcpy(block[0], edges.data(), edges.size() * sizeof(Edge));
+    memcpy(block[1], rank.data(), rank.size() * sizeof(int32_t));
+    memcpy(block[2], upwardOutOffsets.data(), upwardOutOffsets.size() * sizeof(int32_t));
+    memcpy(block[3], upwardOutEdges.data(), upwardOutEdges.size() * sizeof(int32_t));
+    memcpy(block[4], upwardInOffsets.data(), upwardInOffsets.size() * sizeof(int32_t));
+    memcpy(block[5], upwardInEdges.data(), upwardInEdges.size() * sizeof(int32_t));
+
+    bool ok = output.flush();
+    output.close();
+
+    // Replace the old file in one step, so readers never see a half-written hierarchy
+    if (!ok || rename(tempFileName.c_str(), fileName) != 0) {
+        remove(tempFileName.c_str());
+        cout << "Cannot write contraction hierarchy: " << fileName << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Function to load a saved hierarchy and check it matches the current weights file
+// Every vertex and edge id in the file is range-checked, and a shortcut may only point at
+// edges before it, so a damaged file can never make a query read out of bounds or recurse forever
+ContractionHierarchy* ContractionHierarchy::read(const char* fileName, int vertices, uint64_t weightsChecksum) {
+    MappedFile file;
+    if (!file.openReadOnly(fileName))
+        return nullptr;
+
+    HierarchyHeader header;
+    if (file.length() < sizeof(header))
+        return nullptr;
+    memcpy(&header, file.data(), sizeof(header));
+
+    // Reject files of another format, another graph size, or another weights file
+    if (memcmp(header.magic, magicString, sizeof(header.magic)) != 0 || (int)header.vertexCount != vertices ||
+        header.weightsChecksum != weightsChecksum || header.edgeCount > (uint64_t)INT32_MAX ||
+        header.upwardOutCount + header.upwardInCount != header.edgeCount)
+        return nullptr;
+
+    size_t sizes[blockCount];
+    blockSizes(header, sizes);
+    size_t total = sizeof(header);
+    for (size_t size : sizes)
+        total += size;
+    if (file.length() != total)
+        return nullptr;
+
+    const char* block[blockCount];
+    block[0] = file.data() + sizeof(header);
+    for (int b = 1; b < blockCount; b++)
+        block[b] = block[b - 1] + sizes[b - 1];
+
+    ContractionHierarchy* hierarchy = new ContractionHierarchy();
+    hierarchy->gSize = vertices;
+    hierarchy->shortcuts = header.shortcutCount;
+    const Edge* edgeBlock = (const Edge*)block[0];
+    hierarchy->edges.assign(edgeBlock, edgeBlock + header.edgeCount);
+    const int32_t* rankBlock = (const int32_t*)block[1];
+    hierarchy->rank.assign(rankBlock, rankBlock + vertices);
+    const int32_t* outOffsets = (const int32_t*)block[2];
+    const int32_t* outEdges = (const int32_t*)block[3];
+    const int32_t* inOffsets = (const int32_t*)block[4];
+    const int32_t* inEdges = (const int32_t*)block[5];
+    hierarchy->upwardOutOffsets.assign(outOffsets, outOffsets + vertices + 1);
+    hierarchy->upwardOutEdges.assign(outEdges, outEdges + header.upwardOutCount);
+    hierarchy->upwardInOffsets.assign(inOffsets, inOffsets + vertices + 1);
+    hierarchy->upwardInEdges.assign(inEdges, inEdges + header.upwardInCount);
+
+    bool valid = true;
+    int edgeCount = (int)header.edgeCount;
+    for (int id = 0; id < edgeCount && valid; id++) {
+        const Edge& edge = hierarchy->edges[id];
+        valid = edge.from >= 0 && edge.from < vertices && edge.to >= 0 && edge.to < vertices &&
+                (edge.firstChild == -1 ? edge.secondChild == -1
+                                       : edge.firstChild >= 0 && edge.firstChild < id && edge.secondChild >= 0 && edge.secondChild < id);
+    }
+    for (int side = 0; side < 2 && valid; side++) {
+        const vector<int>& offsets = side == 0 ? hierarchy->upwardOutOffsets : hierarchy->upwardInOffsets;
+        const vector<int>& edgeIds = side == 0 ? hierarchy->upwardOutEdges : hierarchy->upwardInEdges;
+        valid = offsets[0] == 0 && offsets[vertices] == (int)edgeIds.size();
+        for (int v = 0; v < vertices && valid; v++)
+            valid = offsets[v] <= offsets[v + 1];
+        for (int id : edgeIds)
+            valid = valid && id >= 0 && id < edgeCount;
+    }
+
+    if (!valid) {
+        delete hierarchy;
+        return nullptr;
+    }
+    return hierarchy;
+}
+
+
+// Function to expand an edge into the original vertices it passes through
+void ContractionHierarchy::unpackEdge(int edge, vector<int>& path) const {
+    if (edges[edge].firstChild == -1) {
+        path.push_back(edges[edge].to);
+        return;
+    }
+    unpackEdge(edges[edge].firstChild, path);
+    unpackEdge(edges[edge].secondChild, path);
+}
+
+
+// Function to find the shortest path with a bidirectional upward search
+// The forward search from the origin and the backward search from the destination both only
+// climb in rank. They are alternated, and each side stops once its smallest queued weight is
+// no better than the best meeting point found so far. The search state is kept per thread,
+// so any number of threads can query one hierarchy at the same time
+double ContractionHierarchy::shortestPath(int origin, int destination, vector<int>& path) {
+    EV_TIMER_LEG("ContractionHierarchy::shortestPath", origin, destination);
+    SearchCounters counters;
+    static thread_local SearchSide forward, backward;
+    path.clear();
+    SearchSide* sides[2] = {&forward, &backward};
+    greater<pair<double, int>> later;
+
+    for (SearchSide* side : sides) {
+        side->workspace.newSearch(gSize);
+        if ((int)side->parentEdge.size() != gSize)
+            side->parentEdge.resize(gSize);
+    }
+    forward.workspace.setDistance(origin, 0);
+    forward.parentEdge[origin] = -1;
+    forward.workspace.heap.push_back(make_pair(0.0, origin));
+    backward.workspace.setDistance(destination, 0);
+    backward.parentEdge[destination] = -1;
+    backward.workspace.heap.push_back(make_pair(0.0, destination));
+    counters.pushes += 2;
+
+    double best = DBL_MAX;
+    int meeting = -1;
+
+    for (int turn = 0; !forward.workspace.heap.empty() || !backward.workspace.heap.empty(); turn ^= 1) {
+        SearchSide& side = *sides[turn];
+        SearchSide& other = *sides[turn ^ 1];
+        vector<pair<double, int>>& heap = side.workspace.heap;
+
+        if (heap.empty())
+            continue;
+        if (heap.front().first >= best) {
+            heap.clear(); // Nothing on this side can improve the answer
+            continue;
+        }
+
+        pop_heap(heap.begin(), heap.end(), later);
+        double weight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        if (weight > side.workspace.distanceOf(v))
+            continue;
+        counters.settled++;
+
+        // Check whether the two searches meet at v
+        double otherWeight = other.workspace.distanceOf(v);
+        if (otherWeight < DBL_MAX && weight + otherWeight < best) {
+            best = weight + otherWeight;
+            meeting = v;
+        }
+
+        // Relax the upward edges of v in this direction
+        const vector<int>& offsets = (turn == 0) ? upwardOutOffsets : upwardInOffsets;
+        const vector<int>& edgeIds = (turn == 0) ? upwardOutEdges : upwardInEdges;
+        counters.relaxed += offsets[v + 1] - offsets[v];
+        for (int k = offsets[v]; k < offsets[v + 1]; k++) {
+            const Edge& edge = edges[edgeIds[k]];
+            int w = (turn == 0) ? edge.to : edge.from;
+            double next = weight + edge.weight;
+
+            if (next < side.workspace.distanceOf(w)) {
+                side.workspace.setDistance(w, next);
+                side.parentEdge[w] = edgeIds[k];
+                heap.push_back(make_pair(next, w));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    }
+
+    if (meeting == -1)
+        return DBL_MAX;
+
+    // Collect the edges origin -> meeting and meeting -> destination, then unpack the shortcuts
+    static thread_local vector<int> upEdges;
+    upEdges.clear();
+    for (int v = meeting; forward.parentEdge[v] != -1; v = edges[forward.parentEdge[v]].from)
+        upEdges.push_back(forward.parentEdge[v]);
+    reverse(upEdges.begin(), upEdges.end());
+    for (int v = meeting; backward.parentEdge[v] != -1; v = edges[backward.parentEdge[v]].to)
+        upEdges.push_back(backward.parentEdge[v]);
+
+    path.push_back(origin);
+    for (int edge : upEdges)
+        unpackEdge(edge, path);
+
+    return best;
+}
+
+
+stack<int> ContractionHierarchy::shortestPath(int origin, int destination) {
+    vector<int> path;
+    stack<int> pathStack;
+
+    if (shortestPath(origin, destination, path) == DBL_MAX) {
+        pathStack.push(destination);
+        return pathStack;
+    }
+
+    for (int k = (int)path.size() - 1; k >= 0; k--)
+        pathStack.push(path[k]);
+    return pathStack;
+}
+
+#endif /* ContractionHierarchy_h */
@@ -8,27 +8,222 @@
 #ifndef EVCharging_h
 #define EVCharging_h
 #include <stack>
+#include <map>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 
 // Include necessary headers for the class
 #include "Location.h"
 #include "WeightedGraph.h"
+#include "AllPairsTable.h"
+#include "ChargingRouter.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "NetworkSnapshot.h"
+#include "NameIndex.h"
+#include "StationTable.h"
+#include "ChargingAmount.h"
+#include "QueryCache.h"
+
+// One query for tasks 4 to 9 and 11, as asked interactively or read by the batch mode
+struct Query {
+    int task = 0;                // Task number
+    int origin = -1;             // Location index of the origin (or the only location)
+    int destination = -1;        // Location index of the destination (tasks 8, 9 and 11)
+    int chargingAmount = 0;      // kWh to charge (tasks 5, 7 to 9); the current charge for task 11
+    double batteryCapacity = 40; // Battery capacity in kWh (task 11)
+
+    bool operator==(const Query& other) const {
+        return task == other.task && origin == other.origin && destination == other.destination &&
+               chargingAmount == other.chargingAmount && batteryCapacity == other.batteryCapacity;
+    }
+};
+
+// Hash of a query, for the answer cache
+struct QueryHash {
+    size_t operator()(const Query& query) const {
+        uint64_t h = (uint64_t)query.task;
+        h = h * 0x9e3779b97f4a7c15ull + (uint32_t)query.origin;
+        h = h * 0x9e3779b97f4a7c15ull + (uint32_t)query.destination;
+        h = h * 0x9e3779b97f4a7c15ull + (uint32_t)query.chargingAmount;
+        h = h * 0x9e3779b97f4a7c15ull + (uint64_t)(query.batteryCapacity * 1024);
+        return (size_t)(h ^ (h >> 29));
+    }
+};
+
+// Answer to a query, filled in by the find functions and printed by the tasks or the batch mode
+struct QueryResult {
+    int task = 0;
+    bool found = false;           // False if no station or route satisfies the query
+    vector<int> stations;         // Adjacent stations (4), the station(s) to charge at (5 to 9) or the stops (11)
+    vector<double> charged;       // kWh charged at each of the stations (5, 7 to 9, 11)
+    bool freeStationFirst = false; // Task 9: the free 25 kWh is charged before the rest
+    double distance = 0;          // Distance to the nearest station in km (6)
+    double chargingCost = 0;      // Dollars spent charging
+    double travelCost = 0;        // Dollars spent driving
+    double arrivalCharge = 0;     // kWh left at the destination (11)
+    vector<int> path;             // Travel path in the order it is printed, origin first (8, 9, 11)
+};
 
 // Class definition for EVCharging, representing an electric vehicle charging system
 class EVCharging {
 private:
     // Private members for storing location information and weighted graph
-    map<int, Location> locations;  // It can also be unordered_map
+    StationTable stations;       // Names, charger flags and prices, one column each, by location index
     int numberOfLocations;
+    NameIndex locationNames;     // Name -> index lookup, built once the locations are loaded
     WeightedGraphType* weightedGraph;
 
-    // Private helper function to get the index of a location based on its name
-    int getIndex(string locationName) {
-        for (const auto& el : locations) {
-            if (el.second.locationName == locationName) {
-                return el.first;
+    // Input files, and the precomputed all-pairs table built from the weights file
+    string locationsFileName = "Locations.txt";
+    string weightsFileName = "Weights.txt";
+    GraphFileFormat weightsFormat = ADJACENCY_MATRIX;
+    string tableFileName = "Distances.bin";
+    string snapshotFileName = "Network.snap"; // Binary copy of both input files, used while it matches them
+    string hierarchyFileName = "Hierarchy.bin"; // Saved contraction hierarchy, used while it matches the weights file
+    AllPairsTable allPairs; // Used for every distance and path when open
+    // Used for point-to-point paths when there is no all-pairs table. Both are read and replaced
+    // with atomic_load and atomic_store, so a query keeps the one it started with
+    shared_ptr<ContractionHierarchy> hierarchy;
+    shared_ptr<LandmarkIndex> landmarks; // Used instead of the hierarchy when useLandmarks asked for it
+    int indexLandmarks;                  // Landmarks this network was loaded with (0: the hierarchy)
+
+    // Landmarks preprocessed by networks loaded from now on (0: a contraction hierarchy instead)
+    static int landmarkCount;
+    static LandmarkSelection landmarkSelection;
+    // Fixed-point scale of the road distances in networks loaded from now on (0: searched as doubles)
+    static int fixedPointScale;
+
+    // Shortest path trees computed so far, keyed by source, so every leg starting
+    // from the same location reuses one search. Trees are shared, so a caller keeps its tree
+    // even if another thread clears the cache meanwhile
+    map<int, shared_ptr<ShortestPathTree>> shortestPathTrees;
+    static const int maxCachedTrees = 64; // The cache is cleared when it grows past this
+
+    // Nearest charging station answers so far: source -> (station, distance). Kept up to
+    // date by updateRoadDistance and updateChargingStation
+    map<int, pair<int, double>> nearestStations;
+
+    // Guards both caches between queries running on several threads at once
+    mutex cacheMutex;
+
+    // Queries through answer hold networkMutex shared and the update functions hold it
+    // exclusively, so an update waits for the queries in flight and the queries after it see
+    // all of it. An update waiting for the lock holds updateGate, which queries pass through
+    // first, so a steady stream of queries cannot hold an update off
+    shared_mutex networkMutex;
+    mutex updateGate;
+
+    // A road change drops the hierarchy (or landmarks whose bounds it broke), and this thread
+    // builds a new one while queries fall back to plain searches. indexBuilding and roadVersion
+    // are guarded by networkMutex
+    thread indexBuilder;
+    atomic<bool> stopping;      // Set by the destructor to cancel a build
+    bool indexBuilding = false; // The builder thread is running
+    uint64_t roadVersion = 0;   // Number of road changes so far
+
+    // Per-thread buffers of cheapestChargingStation, one set for each of its two searches
+    struct StationSearch {
+        DijkstraWorkspace workspace;
+        vector<unsigned> settled;         // Equal to the workspace generation once a location is settled
+        vector<pair<double, int>> waiting; // Min-heap of (cost so far, station) over the stations only this side has settled
+    };
+
+    // Answers of recent queries. dataVersion is bumped by every change of a road or a charger,
+    // which makes all the answers computed before it stale
+    QueryCache<Query, QueryResult, QueryHash> answers;
+    atomic<uint64_t> dataVersion;
+
+    // Private helper function to run the find function of a query's task
+    QueryResult computeAnswer(const Query& query);
+
+    // Private helper function to get the shortest path tree from a location, searching only on a cache miss.
+    // The search runs outside the lock, so two threads may occasionally compute the same tree
+    shared_ptr<const ShortestPathTree> shortestPathTreeFrom(int source) {
+        {
+            lock_guard<mutex> lock(cacheMutex);
+            map<int, shared_ptr<ShortestPathTree>>::iterator it = shortestPathTrees.find(source);
+            if (it != shortestPathTrees.end()) {
+                EV_COUNT(COUNTER_TREE_CACHE_HITS, 1);
+                return it->second;
             }
         }
-        return -1;
+        EV_COUNT(COUNTER_TREE_CACHE_MISSES, 1);
+
+        shared_ptr<ShortestPathTree> tree = make_shared<ShortestPathTree>();
+        if (!weightedGraph->shortestPathTreeFixed<DialQueue>(source, *tree))
+            *tree = weightedGraph->shortestPathTree(source);
+
+        lock_guard<mutex> lock(cacheMutex);
+        if ((int)shortestPathTrees.size() >= maxCachedTrees)
+            shortestPathTrees.clear();
+        shortestPathTrees[source] = tree;
+        return tree;
+    }
+
+    // Private helper function to get the nearest charging station to a location (-1 if none), using the cache
+    int nearestChargingStation(int source, double& distance) {
+        {
+            lock_guard<mutex> lock(cacheMutex);
+            map<int, pair<int, double>>::iterator it = nearestStations.find(source);
+            if (it != nearestStations.end()) {
+                distance = it->second.second;
+                return it->second.first;
+            }
+        }
+
+        int station = weightedGraph->nearestTarget(source, stations.chargerFlags(), distance);
+
+        lock_guard<mutex> lock(cacheMutex);
+        nearestStations[source] = make_pair(station, distance);
+        return station;
+    }
+
+    // Private helper function to get the road distance between two locations, from the
+    // all-pairs table if one is loaded, otherwise from a shortest path tree
+    double travelDistance(int origin, int destination) {
+        EV_TIMER_LEG("travelDistance", origin, destination);
+        if (allPairs.isOpen())
+            return allPairs.distance(origin, destination);
+        return shortestPathTreeFrom(origin)->distance[destination];
+    }
+
+    // Private helper function to get the travel path between two locations, origin first
+    // (only the destination if it cannot be reached), reusing the buffer of path. It comes from
+    // the fastest structure there is: the all-pairs table, the contraction hierarchy, the
+    // landmarks, A* over the coordinates, or else a bidirectional search (Dial's buckets over
+    // the fixed-point distances when they are in use)
+    void travelPath(int origin, int destination, vector<int>& path) {
+        shared_ptr<ContractionHierarchy> currentHierarchy = atomic_load(&hierarchy);
+        shared_ptr<LandmarkIndex> currentLandmarks = atomic_load(&landmarks);
+
+        if (allPairs.isOpen()) {
+            allPairs.path(origin, destination, path);
+        } else if (currentHierarchy != nullptr) {
+            if (currentHierarchy->shortestPath(origin, destination, path) == DBL_MAX)
+                path.assign(1, destination);
+        } else if (currentLandmarks != nullptr && currentLandmarks->isBuilt()) {
+            if (currentLandmarks->shortestPath(origin, destination, path) == DBL_MAX)
+                path.assign(1, destination);
+        } else if (weightedGraph->hasCoordinates()) {
+            if (weightedGraph->shortestPath(origin, destination, path) == DBL_MAX)
+                path.assign(1, destination);
+        } else if (weightedGraph->hasFixedPointWeights()) {
+            if (weightedGraph->shortestPathFixed<DialQueue>(origin, destination, path) == DBL_MAX)
+                path.assign(1, destination);
+        } else {
+            if (weightedGraph->shortestPathBidirectional(origin, destination, path) == DBL_MAX)
+                path.assign(1, destination);
+        }
+    }
+
+    // Private helper function to get the index of a location based on its name (case is
+    // ignored when there is no exact match)
+    int getIndex(string locationName) {
+        return locationNames.find(locationName);
     }
 
     // Private helper function to get user input for location
@@ -43,18 +238,58 @@ private:
 
         if (index == -1) {
             cout << "There is no location: " << locationName << endl;
+
+            // Suggest the names that start with what was typed
+            vector<string> suggestions = completeLocationName(locationName, 5);
+            for (size_t i = 0; i < suggestions.size(); i++)
+                cout << (i == 0 ? "Did you mean: " : ", ") << suggestions[i];
+            if (!suggestions.empty())
+                cout << endl;
         }
         return index;
     }
 
+    // Private helper function to read the input files (or their snapshot) and build the indices, for the constructors
+    void loadNetwork();
+    // Private helper function run by indexBuilder: rebuild the hierarchy or the landmarks for the current roads
+    void rebuildIndex();
+    // Private helper function to load the locations and the graph from the snapshot, if it matches the input files
+    bool loadSnapshot(uint64_t weightsChecksum, uint64_t locationsChecksum);
+
     // Private helper function to find the cheapest charging station given specific conditions
     int cheapestChargingStation(int origin, int destination, int avoid, int chargingAmount, double& travelCost, double& chargingCost);
 
+    // Private helper functions to build and print the parts of a result
+    void appendTravelPath(vector<int>& path, int from, int to, bool dropLast);
+    void printCosts(const QueryResult& result);
+    void printPath(const vector<int>& path);
+
 public:
     // Constructor and Destructor
     EVCharging();
+    // Load another network than Locations.txt and Weights.txt, with the weights in the given format
+    EVCharging(const string& locationsFile, const string& weightsFile, GraphFileFormat format = ADJACENCY_MATRIX);
     ~EVCharging();
 
+    // Build the all-pairs distance table from the weights file and start using it (offline precompute mode)
+    bool precomputeDistances(int threads = 0);
+    // Write the binary snapshot of the locations and the graph, and the contraction hierarchy if one is
+    // in use, so later runs skip parsing the text files and contracting the graph
+    bool writeSnapshot();
+    // Preprocess count ALT landmarks instead of a contraction hierarchy in the networks loaded
+    // from now on (0 goes back to the hierarchy). Landmarks build with 2 * count searches, far
+    // quicker than the hierarchy on large networks, but their legs settle more vertices
+    static void useLandmarks(int count, LandmarkSelection selection = LANDMARKS_AVOID) {
+        landmarkCount = max(0, count);
+        landmarkSelection = selection;
+    }
+    // Search the road distances of the networks loaded from now on as integer multiples of
+    // 1 / scale (0 goes back to doubles), with Dial's buckets for the shortest path trees. A
+    // network with a distance that is not such a multiple keeps searching doubles
+    static void useFixedPointWeights(int scale = 10) {
+        fixedPointScale = max(0, scale);
+    }
+
     // Public member functions for various tasks
     void inputLocations();
     void printLocations();
@@ -66,58 +301,400 @@ public:
     void cheapestStationOther();
     void cheapestChargingPath();
     void bestChargingPath();
+    void multiStopChargingPath();
+
+    // The computations behind tasks 4 to 9 and 11, without any input or output
+    QueryResult findAdjacentStations(int index);
+    QueryResult findCheapestAdjacentStation(int index, int chargingAmount);
+    QueryResult findNearestStation(int index);
+    QueryResult findOtherCheapestStation(int index, int chargingAmount);
+    QueryResult findCheapestChargingPath(int origin, int destination, int chargingAmount);
+    QueryResult findBestChargingPath(int origin, int destination, int chargingAmount);
+    QueryResult findMultiStopPath(int origin, int destination, const BatteryProfile& battery);
+
+    // Answer a query by running the find function of its task, or from the cache if the same
+    // query was answered since the last change of the data. Any number of threads may call it
+    // while the update functions run; the find functions above may not
+    QueryResult answer(const Query& query);
+    // Get the hit, eviction and memory counters of the answer cache
+    QueryCacheStats answerCacheStats() {
+        return answers.stats();
+    }
+
+    // Get the number of locations
+    int getNumberOfLocations() const {
+        return numberOfLocations;
+    }
+    // Get the index of a location by name, ignoring case if there is no exact match (-1 if none)
+    int findLocation(const string& locationName) const {
+        return locationNames.find(locationName);
+    }
+    // Get the name of a location
+    string_view locationName(int index) const {
+        return stations.name(index);
+    }
+    // Get the charger details of a location
+    Location locationRow(int index) const {
+        return stations.location(index);
+    }
+
+    // Find the cheapest route between two locations for a vehicle with the given battery,
+    // with as many charging stops as it needs
+    ChargingPlan planChargingTrip(int origin, int destination, const BatteryProfile& battery) {
+        ChargingRouter router(*weightedGraph, stations.chargerFlags(), stations.priceColumn());
+        return router.plan(origin, destination, battery);
+    }
+
+    // Change the length of the road from -> to (one direction; DBL_MAX closes it) and repair
+    // the cached answers. Returns false if there is no such road
+    bool updateRoadDistance(int from, int to, double distance);
+    // Change whether a location has a charger and what it costs, and repair the cached answers.
+    // Returns false if there is no such location
+    bool updateChargingStation(int index, bool installed, double price);
+    // Check whether a contraction hierarchy or landmarks are being rebuilt after a road change
+    bool rebuildingIndex() {
+        shared_lock<shared_mutex> lock(networkMutex);
+        return indexBuilding;
+    }
+
+    // Get up to limit location names starting with the prefix (ignoring case), for autocomplete
+    vector<string> completeLocationName(const string& prefix, int limit) {
+        vector<string> completions;
+        for (int index : locationNames.findPrefix(prefix, limit))
+            completions.push_back(string(stations.name(index)));
+        return completions;
+    }
+
+    // Find the k charging stations nearest to a location, nearest first, as (index, distance) pairs
+    vector<pair<int, double>> nearestChargingStations(int index, int k) {
+        return weightedGraph->nearestTargets(index, stations.chargerFlags(), k);
+    }
 };
 
+int EVCharging::landmarkCount = 0;
+LandmarkSelection EVCharging::landmarkSelection = LANDMARKS_AVOID;
+int EVCharging::fixedPointScale = 0;
+
 // Implementation of the EVCharging class
 
 // Constructor
-EVCharging::EVCharging() {
-    inputLocations();
-    weightedGraph = new WeightedGraphType(numberOfLocations);
+EVCharging::EVCharging() : stopping(false), dataVersion(0) {
+    loadNetwork();
+}
+
+// Constructor for another network; its table, snapshot and hierarchy are kept next to its weights file
+EVCharging::EVCharging(const string& locationsFile, const string& weightsFile, GraphFileFormat format)
+    : locationsFileName(locationsFile), weightsFileName(weightsFile), weightsFormat(format),
+      tableFileName(weightsFile + ".dist"), snapshotFileName(weightsFile + ".snap"),
+      hierarchyFileName(weightsFile + ".ch"), stopping(false), dataVersion(0) {
+    loadNetwork();
+}
+
+// Function to load the locations and the graph, then prepare the distance structures
+void EVCharging::loadNetwork() {
+    indexLandmarks = landmarkCount;
+    numberOfLocations = 0;
+    uint64_t weightsChecksum = fileChecksum(weightsFileName.c_str());
+    uint64_t locationsChecksum = fileChecksum(locationsFileName.c_str());
+
+    // Parse the text files only when there is no up-to-date snapshot of them
+    if (!loadSnapshot(weightsChecksum, locationsChecksum)) {
+        inputLocations();
+        weightedGraph = new WeightedGraphType(numberOfLocations, weightsFileName.c_str(), weightsFormat);
+    }
+
+    // Give the graph the coordinates of the locations (if the file has them all) for A* searches
+    weightedGraph->setCoordinates(stations.latitudeColumn(), stations.longitudeColumn());
+    if (fixedPointScale > 0 && !weightedGraph->useFixedPointWeights(fixedPointScale))
+        cout << "Road distances are not all multiples of 1/" << fixedPointScale << ", searching them as doubles." << endl;
+
+    // Index the names for getIndex and autocomplete
+    vector<string> names;
+    for (int i = 0; i < numberOfLocations; i++)
+        names.push_back(string(stations.name(i)));
+    locationNames.build(move(names));
+
+    // Map the precomputed all-pairs table if there is one. A table built from an
+    // older weights file is detected by its checksum and rebuilt
+    if (!allPairs.open(tableFileName.c_str(), numberOfLocations, weightsChecksum) && ifstream(tableFileName)) {
+        cout << "All-pairs table " << tableFileName << " is out of date, rebuilding it." << endl;
+        precomputeDistances();
+    }
+
+    // Without a table, preprocess landmarks or a contraction hierarchy for the point-to-point legs.
+    // A saved hierarchy is loaded instead of contracting the graph again; one saved from an older
+    // weights file is rebuilt and saved again
+    if (!allPairs.isOpen()) {
+        if (indexLandmarks > 0) {
+            landmarks = make_shared<LandmarkIndex>();
+            if (!landmarks->build(*weightedGraph, indexLandmarks, landmarkSelection))
+                cout << "Cannot choose " << indexLandmarks << " landmarks, searching without them." << endl;
+        } else {
+            hierarchy.reset(ContractionHierarchy::read(hierarchyFileName.c_str(), numberOfLocations, weightsChecksum));
+            if (hierarchy == nullptr) {
+                hierarchy = make_shared<ContractionHierarchy>(*weightedGraph);
+                if (ifstream(hierarchyFileName)) {
+                    cout << "Contraction hierarchy " << hierarchyFileName << " is out of date, rebuilding it." << endl;
+                    hierarchy->write(hierarchyFileName.c_str(), weightsChecksum);
+                }
+            }
+        }
+    }
+}
+
+// Function to build the all-pairs table and map it
+bool EVCharging::precomputeDistances(int threads) {
+    allPairs.close();
+    uint64_t checksum = fileChecksum(weightsFileName.c_str());
+
+    if (!AllPairsTable::build(*weightedGraph, checksum, tableFileName.c_str(), threads))
+        return false;
+    return allPairs.open(tableFileName.c_str(), numberOfLocations, checksum);
+}
+
+// Function to load the snapshot
+// The graph is only kept if the snapshot also holds a matching set of locations
+bool EVCharging::loadSnapshot(uint64_t weightsChecksum, uint64_t locationsChecksum) {
+    vector<string> names;
+    vector<bool> chargerInstalled;
+    vector<double> chargingPrices, latitudes, longitudes;
+    weightedGraph = new WeightedGraphType(0, nullptr);
+
+    if (!NetworkSnapshot::read(snapshotFileName.c_str(), weightsChecksum, locationsChecksum, *weightedGraph, names, chargerInstalled,
+                               chargingPrices, latitudes, longitudes) ||
+        (int)names.size() != weightedGraph->getNumberOfVertices()) {
+        delete weightedGraph;
+        weightedGraph = nullptr;
+        return false;
+    }
+
+    stations.build(names, chargerInstalled, chargingPrices, latitudes, longitudes);
+    numberOfLocations = (int)names.size();
+    return true;
+}
+
+// Function to write the snapshot of the current input files, and the contraction hierarchy if one is in use
+bool EVCharging::writeSnapshot() {
+    vector<string> names;
+    for (int i = 0; i < numberOfLocations; i++)
+        names.push_back(string(stations.name(i)));
+
+    shared_ptr<ContractionHierarchy> currentHierarchy = atomic_load(&hierarchy);
+    if (currentHierarchy != nullptr && !currentHierarchy->write(hierarchyFileName.c_str(), fileChecksum(weightsFileName.c_str())))
+        return false;
+    return NetworkSnapshot::write(snapshotFileName.c_str(), *weightedGraph, names, stations.chargerFlags(), stations.priceColumn(),
+                                  stations.latitudeColumn(), stations.longitudeColumn(),
+                                  fileChecksum(weightsFileName.c_str()), fileChecksum(locationsFileName.c_str()));
 }
 
 // Destructor
+// A build still running is cancelled; the builder sees stopping and drops its result
 EVCharging::~EVCharging() {
+    stopping = true;
+    if (indexBuilder.joinable())
+        indexBuilder.join();
     delete weightedGraph;
 }
 
-// Function to read charging location information from a file
-void EVCharging::inputLocations() {
-    // Implementation details for reading location information from a file
-    // (Assuming the file format includes locationName, chargerInstalled, chargingPrice)
-    ifstream infile;
-    char fileName[50] = "Locations.txt";
+// Function to change a road length while the program runs
+// Cached shortest path trees are repaired in place (only the part of each tree the change
+// reaches is searched again). The all-pairs table and the contraction hierarchy describe the
+// old weights, so they are dropped, and the builder thread contracts the new roads meanwhile;
+// the table is not rebuilt, since the hierarchy answers its legs once it is back. Landmark bounds
+// only underestimate more when a road gets longer, so landmarks are kept unless it got shorter.
+// A cached nearest station only depends on roads whose tail is closer to the source than the
+// station; a road's tail distance does not depend on the road itself, so the repaired tree
+// tells which cached answers to recompute. Answers without a cached tree are recomputed lazily
+bool EVCharging::updateRoadDistance(int from, int to, double distance) {
+    lock_guard<mutex> gate(updateGate);
+    unique_lock<shared_mutex> lock(networkMutex);
+
+    double oldDistance = weightedGraph->getWeight(from, to);
+    if (!weightedGraph->updateEdgeWeight(from, to, distance))
+        return false;
+    dataVersion++;
+    roadVersion++;
+
+    allPairs.close();
+    atomic_store(&hierarchy, shared_ptr<ContractionHierarchy>());
+    if (distance < oldDistance)
+        atomic_store(&landmarks, shared_ptr<LandmarkIndex>()); // Its bounds may now be too high; a longer road leaves them valid
+
+    // Start the builder unless it is running already; a running one sees the new version and starts over
+    if (!indexBuilding && (indexLandmarks == 0 || atomic_load(&landmarks) == nullptr)) {
+        if (indexBuilder.joinable())
+            indexBuilder.join(); // It has finished: indexBuilding was cleared under this lock
+        indexBuilding = true;
+        indexBuilder = thread(&EVCharging::rebuildIndex, this);
+    }
+
+    for (map<int, shared_ptr<ShortestPathTree>>::iterator it = shortestPathTrees.begin(); it != shortestPathTrees.end(); it++)
+        weightedGraph->repairShortestPathTree(*it->second, from, to, oldDistance);
+
+    for (map<int, pair<int, double>>::iterator it = nearestStations.begin(); it != nearestStations.end();) {
+        map<int, shared_ptr<ShortestPathTree>>::iterator tree = shortestPathTrees.find(it->first);
+        bool unaffected = tree != shortestPathTrees.end() && tree->second->distance[from] >= it->second.second;
+
+        if (unaffected)
+            it++;
+        else
+            it = nearestStations.erase(it);
+    }
+    return true;
+}
+
+// Function to change the charger details of a location while the program runs
+// Turning a charger off only invalidates the answers that pointed at it. Turning one on
+// can only beat answers whose source has a cached tree showing it is closer; answers
+// without a tree are recomputed lazily
+bool EVCharging::updateChargingStation(int index, bool installed, double price) {
+    lock_guard<mutex> gate(updateGate);
+    unique_lock<shared_mutex> lock(networkMutex);
+
+    if (index < 0 || index >= numberOfLocations)
+        return false;
+    bool wasInstalled = stations.hasCharger(index);
+    stations.update(index, installed, price);
+    dataVersion++;
+
+    if (installed == wasInstalled)
+        return true;
+
+    for (map<int, pair<int, double>>::iterator it = nearestStations.begin(); it != nearestStations.end();) {
+        int source = it->first;
+        bool keep;
+
+        if (!installed) {
+            keep = it->second.first != index;
+        } else if (source == index) {
+            keep = true; // A location is never its own nearest station
+        } else {
+            map<int, shared_ptr<ShortestPathTree>>::iterator tree = shortestPathTrees.find(source);
+            keep = tree != shortestPathTrees.end();
+            if (keep) {
+                // Same tie rule as the search: nearer first, then the lower index
+                double distance = tree->second->distance[index];
+                pair<int, double>& answer = it->second;
+                if (distance < answer.second || (distance == answer.second && distance < DBL_MAX && index < answer.first))
+                    answer = make_pair(index, distance);
+            }
+        }
+
+        if (keep)
+            it++;
+        else
+            it = nearestStations.erase(it);
+    }
+    return true;
+}
+
+// Function to rebuild the hierarchy or the landmarks after road changes, on the builder thread
+// The hierarchy is contracted from a copy of the open roads, so queries and further updates go
+// on meanwhile. Landmarks keep searching the live graph, so they are built under the shared
+// lock; their 2 * count searches are quick. If the roads changed during the build, its result
+// is already stale and the builder starts over: a burst of updates costs one more build, not one each
+void EVCharging::rebuildIndex() {
+    while (true) {
+        uint64_t version;
+        shared_ptr<ContractionHierarchy> builtHierarchy;
+        shared_ptr<LandmarkIndex> builtLandmarks;
+
+        if (indexLandmarks > 0) {
+            shared_lock<shared_mutex> lock(networkMutex);
+            version = roadVersion;
+            builtLandmarks = make_shared<LandmarkIndex>();
+            builtLandmarks->build(*weightedGraph, indexLandmarks, landmarkSelection);
+        } else {
+            // Closed roads (DBL_MAX) are left out, so no shortcut runs through them
+            int size = weightedGraph->getNumberOfVertices();
+            vector<int> offsets(1, 0), targets;
+            vector<double> weights;
+            {
+                shared_lock<shared_mutex> lock(networkMutex);
+                version = roadVersion;
+                for (int v = 0; v < size; v++) {
+                    for (int e = weightedGraph->edgeBegin(v); e < weightedGraph->edgeEnd(v); e++) {
+                        if (weightedGraph->edgeWeight(e) == DBL_MAX)
+                            continue;
+                        targets.push_back(weightedGraph->edgeTarget(e));
+                        weights.push_back(weightedGraph->edgeWeight(e));
+                    }
+                    offsets.push_back((int)targets.size());
+                }
+            }
 
-//    cout << "Enter charging location file name: ";
-//    cin >> fileName;
-//    cout << endl;
+            WeightedGraphType roads(0, nullptr);
+            roads.setEdges(size, offsets, targets, weights);
+            builtHierarchy = make_shared<ContractionHierarchy>(roads, 500, &stopping);
+        }
 
-    infile.open(fileName);
+        lock_guard<mutex> gate(updateGate);
+        unique_lock<shared_mutex> lock(networkMutex);
+        if (stopping || version == roadVersion) {
+            if (!stopping) {
+                if (builtHierarchy != nullptr)
+                    atomic_store(&hierarchy, builtHierarchy);
+                else
+                    atomic_store(&landmarks, builtLandmarks);
+            }
+            indexBuilding = false;
+            return;
+        }
+    }
+}
 
-    if (!infile) {
+// Function to read charging location information from a file
+void EVCharging::inputLocations() {
+    // Each line holds locationName,chargerInstalled,chargingPrice and optionally ,latitude,longitude
+    // in degrees. The file is mapped and parsed in place; a malformed line stops the input with
+    // its line and column
+    MappedFile file;
+    if (!file.openReadOnly(locationsFileName.c_str())) {
         cout << "Cannot open input file." << endl;
         return;
     }
 
-    int locationIndex = 0;
-
-    while (!infile.eof()) {
-        Location s;
-        string charger;
-        string price;
-        while (!infile.eof()) {
-            getline(infile, s.locationName, ',');
-            getline(infile, charger, ',');
-            getline(infile, price);
-            s.chargerInstalled = (stoi(charger) == 1) ? true : false;
-            s.chargingPrice = stod(price);
-            s.index = locationIndex;
-            locations[locationIndex] = s;
-            locationIndex++;
+    TextScanner scanner(file.data(), file.length(), locationsFileName.c_str());
+    vector<string> names;
+    vector<bool> chargerInstalled;
+    vector<double> chargingPrices;
+    vector<double> latitudes, longitudes;
+
+    while (true) {
+        // Skip blank lines, including the one after the last line
+        scanner.skipWhitespace();
+        if (scanner.atEnd())
+            break;
+
+        const char* name;
+        size_t nameLength;
+        int charger;
+        double price;
+        if (!scanner.readField(',', name, nameLength) || !scanner.expect(',') || !scanner.readNumber(charger, false) ||
+            !scanner.expect(',') || !scanner.readNumber(price, false))
+            break;
+        double latitude = NAN, longitude = NAN;
+        if (scanner.peek() == ',' && (!scanner.expect(',') || !scanner.readNumber(latitude, false) ||
+                                      !scanner.expect(',') || !scanner.readNumber(longitude, false)))
+            break;
+        if (!scanner.atEndOfLine()) {
+            scanner.fail("expected the end of the line");
+            break;
         }
+
+        names.push_back(string(name, nameLength));
+        chargerInstalled.push_back((charger == 1) ? true : false);
+        chargingPrices.push_back(price);
+        latitudes.push_back(latitude);
+        longitudes.push_back(longitude);
     }
 
-    numberOfLocations = locationIndex;
+    if (scanner.hasFailed())
+        scanner.printError();
+
+    // Store the rows column by column
+    stations.build(names, chargerInstalled, chargingPrices, latitudes, longitudes);
+    numberOfLocations = stations.size();
 }
 
 // Function to print information about all charging locations
@@ -126,10 +703,8 @@ void EVCharging::printLocations() {
     cout << "List of locations and charging information " << endl;
     cout << setw (8) << "Index" << setw (20) << "Location name" << setw (20) <<"Charging station" << setw(20) << "Charging price" << endl;
 
-    map<int, Location>::iterator it = locations.begin();
-
-    for (; it != locations.end(); it++) {
-        it->second.printLocation();
+    for (int i = 0; i < numberOfLocations; i++) {
+        stations.location(i).printLocation();
     }
 
     cout << endl;
@@ -142,14 +717,14 @@ void EVCharging::printAdjacencyMatrix() {
     // Display the header row with location names
     cout << setw(13) << " ";
     for (int i = 0; i < numberOfLocations; i++) {
-        cout << setw(13) << locations[i].locationName;
+        cout << setw(13) << stations.name(i);
     }
     cout << endl;
 
     // Iterate over each location to print the adjacency matrix
     for (int i = 0; i < numberOfLocations; i++) {
         // Display the location name in the leftmost column
-        cout << setw(13) << locations[i].locationName;
+        cout << setw(13) << stations.name(i);
 
         // Iterate over each location again to fill in the distances
         for (int j = 0; j < numberOfLocations; j++) {
@@ -167,25 +742,30 @@ void EVCharging::printAdjacencyMatrix() {
 
 //-----------------------------------------------------Task 3-------------------------------------------
 void EVCharging::chargingStationPriceAsc() {
-    // Vector to store charging locations with installed chargers
-    vector<Location> locationPrice;
-
-    // Iterate over all locations to filter those with installed chargers
-    for (map<int, Location>::iterator it = locations.begin(); it != locations.end(); it++) {
-        if (it->second.chargerInstalled)
-            locationPrice.push_back(it->second);
+    // The station table keeps the charging locations sorted by price, so they are printed in that order
+    for (int index : stations.byPrice()) {
+        stations.location(index).printLocation();
     }
+}
 
-    // Sort the vector in ascending order based on charging prices
-    sort(locationPrice.begin(), locationPrice.end());
-
-    // Print information about each charging location in sorted order
-    for (int i = 0; i < locationPrice.size(); i++) {
-        locationPrice[i].printLocation();
+//-----------------------------------------------------Task 4-------------------------------------------
+// Function to find the charging stations adjacent to a location, in index order
+QueryResult EVCharging::findAdjacentStations(int index) {
+    EV_TIMER("findAdjacentStations");
+    QueryResult result;
+    result.task = 4;
+
+    // Iterate over the open roads leaving the input location
+    for (int e = weightedGraph->edgeBegin(index); e < weightedGraph->edgeEnd(index); e++) {
+        // Keep the adjacent location if it has a charging station
+        if (weightedGraph->edgeWeight(e) != DBL_MAX && stations.hasCharger(weightedGraph->edgeTarget(e)))
+            result.stations.push_back(weightedGraph->edgeTarget(e));
     }
+
+    result.found = !result.stations.empty();
+    return result;
 }
 
-//-----------------------------------------------------Task 4-------------------------------------------
 void EVCharging::adjacentCharginStations() {
     // Get user input for the location
     int index = getLocationInput();
@@ -195,27 +775,55 @@ void EVCharging::adjacentCharginStations() {
         return;
     }
 
-    // Flag to track whether any charging stations were found
-    bool found = false;
+    EV_TIMER("task 4");
+    QueryResult result = answer({4, index});
 
-    // Iterate over the adjacency list of the input location
-    for (int i : weightedGraph->getAdjancencyList(index)) {
-        // Check if the adjacent location has a charging station
-        if (locations[i].chargerInstalled) {
-            // Print the name of the adjacent charging station
-            cout << endl << locations[i].locationName << endl;
-            found = true;
-        }
+    // Print the name of every adjacent charging station
+    for (int station : result.stations) {
+        cout << endl << stations.name(station) << endl;
     }
 
     // Display a message if no charging stations are adjacent to the input location
     cout << endl;
-    if (!found) {
-        cout << "No charging station adjacent to " << locations[index].locationName << endl;
+    if (!result.found) {
+        cout << "No charging station adjacent to " << stations.name(index) << endl;
     }
 }
 
 //-----------------------------------------------------Task 5-------------------------------------------
+// Function to find the adjacent station where charging plus the round trip costs least
+QueryResult EVCharging::findCheapestAdjacentStation(int index, int chargingAmount) {
+    EV_TIMER("findCheapestAdjacentStation");
+    QueryResult result;
+    result.task = 5;
+
+    // Gather the locations adjacent over an open road with the cost of the round trip to each
+    // (in buffers kept per thread)
+    static thread_local vector<int> candidates;
+    static thread_local vector<double> travelCosts;
+    candidates.clear();
+    travelCosts.clear();
+    for (int e = weightedGraph->edgeBegin(index); e < weightedGraph->edgeEnd(index); e++) {
+        if (weightedGraph->edgeWeight(e) == DBL_MAX)
+            continue;
+        candidates.push_back(weightedGraph->edgeTarget(e));
+        travelCosts.push_back(weightedGraph->edgeWeight(e) * 2 * 0.1);
+    }
+
+    // Pick the cheapest station among them; free stations only give up to 25 kWh
+    double lowestCost = DBL_MAX;
+    int lowestID = stations.cheapestCandidate(candidates.data(), travelCosts.data(), (int)candidates.size(), chargingAmount, 25, lowestCost);
+
+    if (lowestID != -1) {
+        result.found = true;
+        result.stations.push_back(lowestID);
+        result.charged.push_back(chargingAmount);
+        result.travelCost = weightedGraph->getWeight(index, lowestID) * 2 * 0.1;
+        result.chargingCost = chargingAmount * stations.price(lowestID);
+    }
+    return result;
+}
+
 void EVCharging::cheapestAdjacentStation() {
     // Get user input for the location
     int index = getLocationInput();
@@ -225,39 +833,41 @@ void EVCharging::cheapestAdjacentStation() {
         return;
     }
 
-    // Randomly generate a charging amount between 10 and 50 kWh
-    int chargingAmount = rand() % 41 + 10;
+    // Draw a charging amount between 10 and 50 kWh (reproducible for a given --seed)
+    int chargingAmount = ChargingAmount::next();
     cout << "Charging amount: " << chargingAmount << " kWh" << endl;
 
-    // Variables to track the lowest cost and the corresponding charging station ID
-    double lowestCost = DBL_MAX;
-    int lowestID = -1;
-
-    // Iterate over the adjacency list of the input location
-    for (int i : weightedGraph->getAdjancencyList(index)) {
-        // Calculate the cost of charging at the current adjacent charging station
-        double cost = weightedGraph->getWeight(index, i) * 2 * 0.1 + chargingAmount * locations[i].chargingPrice;
-
-        // Check if the charging station is installed, cost is lower, and charging amount is valid
-        if (locations[i].chargerInstalled && cost < lowestCost) {
-            if (locations[i].chargingPrice > 0 || chargingAmount <= 25) {
-                // Update the lowest cost and corresponding charging station ID
-                lowestCost = cost;
-                lowestID = i;
-            }
-        }
-    }
+    EV_TIMER("task 5");
+    QueryResult result = answer({5, index, -1, chargingAmount});
 
     // Display the result based on whether a cheapest charging station was found
-    if (lowestID != -1) {
-        cout << "The cheapest charging station near you is: " << locations[lowestID].locationName << endl;
-        cout << "Charging will cost: $" << static_cast<double>(lowestCost) << endl;
+    if (result.found) {
+        cout << "The cheapest charging station near you is: " << stations.name(result.stations[0]) << endl;
+        cout << "Charging will cost: $" << result.travelCost + result.chargingCost << endl;
     } else {
-        cout << "No charging station adjacent to " << locations[index].locationName << endl;
+        cout << "No charging station adjacent to " << stations.name(index) << endl;
     }
 }
 
 //-----------------------------------------------------Task 6-------------------------------------------
+// Function to find the nearest charging station to a location by road
+QueryResult EVCharging::findNearestStation(int index) {
+    EV_TIMER("findNearestStation");
+    QueryResult result;
+    result.task = 6;
+
+    // Search outwards from the input location until the first charging station is settled
+    double nearest;
+    int nearestStation = nearestChargingStation(index, nearest);
+
+    if (nearestStation != -1) {
+        result.found = true;
+        result.stations.push_back(nearestStation);
+        result.distance = nearest;
+    }
+    return result;
+}
+
 void EVCharging::closestChargingStation() {
     // Get user input for the location
     int index = getLocationInput();
@@ -267,27 +877,191 @@ void EVCharging::closestChargingStation() {
         return;
     }
 
-    // Compute the shortest path distances from the input location to all other locations
-    vector<double> shortestPath = weightedGraph->shortestPath(index);
+    EV_TIMER("task 6");
+    QueryResult result = answer({6, index});
 
-    // Variables to track the nearest charging station and the corresponding distance
-    double nearest = DBL_MAX;
-    int nearestStation = 0;
-
-    // Iterate through the shortest path distances to find the nearest charging station
-    for (int i = 0; i < shortestPath.size(); i++) {
-        // Check if the location is not the input location, has a charging station, and has a shorter path
-        if (i != index && locations[i].chargerInstalled && shortestPath[i] < nearest) {
-            // Update the nearest charging station and corresponding distance
-            nearest = shortestPath[i];
-            nearestStation = i;
+    // Display the result based on whether a nearest charging station was found
+    if (result.found) {
+        cout << stations.name(result.stations[0]) << " is the nearest charging station to you, with a distance of " << result.distance << " km" << endl;
+    } else {
+        cout << "No charging station can be reached from " << stations.name(index) << endl;
+    }
+}
+//-----------------------------------------------------Cheapest charging station----------------------------
+
+/* Finds the charging station s that minimises the cost of travelling origin -> s -> destination
+ * ($0.10 per km) plus charging chargingAmount kWh at s. One search runs forward from the origin and
+ * one backward from the destination over the reverse index, each step settling a location on the
+ * side with the nearer heap top. A station is priced exactly once both sides have settled it:
+ *     0.1 * (d(origin, s) + d(s, destination)) + chargingAmount * price(s)
+ * Every station not priced yet costs at least the smallest of
+ *     0.1 * (both heap tops) + the smallest charge   (settled by neither side)
+ *     the cost so far of a station one side has settled + 0.1 * the other side's heap top
+ * so the searches stop once that is no less than the cheapest priced station. The costs are exact
+ * even for a negative amount, the work does not depend on how many stations there are, and a round
+ * trip (task 7) stops as soon as a good station near its start is priced from both sides.
+ * The station `avoid` never charges, and free stations only charge up to 25 kWh.
+ * Of equally cheap stations found, the lowest-numbered wins. Returns -1 (and leaves the costs
+ * unchanged) if no station works.
+ */
+int EVCharging::cheapestChargingStation(int origin, int destination, int avoid, int chargingAmount, double& travelCost, double& chargingCost) {
+    EV_TIMER_LEG("cheapestChargingStation", origin, destination);
+    SearchCounters counters;
+    int n = numberOfLocations;
+
+    // A station can charge unless it is avoided, or free and the amount is over 25 kWh
+    auto usable = [&](int v) {
+        return stations.hasCharger(v) && v != avoid && (stations.price(v) > 0 || chargingAmount <= 25);
+    };
+
+    // The smallest charge at a usable station: the cheapest one, or the dearest for a negative amount
+    const vector<int>& byPrice = stations.byPrice();
+    double smallestCharge = HUGE_VAL;
+    for (int k = 0; k < (int)byPrice.size(); k++) {
+        int v = chargingAmount >= 0 ? byPrice[k] : byPrice[byPrice.size() - 1 - k];
+        if (usable(v)) {
+            smallestCharge = chargingAmount * stations.price(v);
+            break;
         }
     }
+    if (smallestCharge == HUGE_VAL)
+        return -1;
 
-    // Display the result based on whether a nearest charging station was found
-    cout << locations[nearestStation].locationName << " is the nearest charging station to you, with a distance of " << nearest << " km" << endl;
+    // The buffers are kept per thread and only the entries marked with the current generation are
+    // valid, so nothing is cleared or allocated
+    static thread_local StationSearch sides[2];
+    greater<pair<double, int>> later;
+    for (int d = 0; d < 2; d++) {
+        StationSearch& side = sides[d];
+        side.workspace.newSearch(n);
+        if ((int)side.settled.size() != n)
+            side.settled.assign(n, 0);
+        side.waiting.clear();
+        int start = d == 0 ? origin : destination;
+        side.workspace.setDistance(start, 0);
+        side.workspace.heap.push_back(make_pair(0.0, start));
+        counters.pushes++;
+    }
+    StationSearch& forward = sides[0];
+    StationSearch& backward = sides[1];
+
+    double bestCost = HUGE_VAL;
+    int bestStation = -1;
+
+    while (true) {
+        double forwardTop = forward.workspace.heap.empty() ? HUGE_VAL : forward.workspace.heap.front().first;
+        double backwardTop = backward.workspace.heap.empty() ? HUGE_VAL : backward.workspace.heap.front().first;
+
+        // Lower bound of the stations not priced yet; stations both sides have settled leave the waiting heaps
+        double bound = 0.1 * (forwardTop + backwardTop) + smallestCharge;
+        for (int d = 0; d < 2; d++) {
+            StationSearch& side = sides[d];
+            StationSearch& other = sides[1 - d];
+            while (!side.waiting.empty() && other.settled[side.waiting.front().second] == other.workspace.generation) {
+                pop_heap(side.waiting.begin(), side.waiting.end(), later);
+                side.waiting.pop_back();
+            }
+            if (!side.waiting.empty())
+                bound = min(bound, side.waiting.front().first + 0.1 * (d == 0 ? backwardTop : forwardTop));
+        }
+        if (bound >= bestCost || (forwardTop == HUGE_VAL && backwardTop == HUGE_VAL))
+            break;
+
+        // Settle the nearer heap top; the backward side follows the edges entering v
+        int d = forwardTop <= backwardTop ? 0 : 1;
+        StationSearch& side = sides[d];
+        StationSearch& other = sides[1 - d];
+        vector<pair<double, int>>& heap = side.workspace.heap;
+
+        pop_heap(heap.begin(), heap.end(), later);
+        double minWeight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        if (minWeight > side.workspace.distanceOf(v))
+            continue;
+        side.settled[v] = side.workspace.generation;
+        counters.settled++;
+
+        // Price a station once both sides have settled it, otherwise let it wait for the other side
+        if (usable(v)) {
+            double charge = chargingAmount * stations.price(v);
+            if (other.settled[v] == other.workspace.generation) {
+                double cost = 0.1 * (minWeight + other.workspace.distanceOf(v)) + charge;
+                if (cost < bestCost || (cost == bestCost && v < bestStation)) {
+                    bestCost = cost;
+                    bestStation = v;
+                    travelCost = 0.1 * (forward.workspace.distanceOf(v) + backward.workspace.distanceOf(v));
+                    chargingCost = charge;
+                }
+            } else {
+                side.waiting.push_back(make_pair(0.1 * minWeight + charge, v));
+                push_heap(side.waiting.begin(), side.waiting.end(), later);
+            }
+        }
+
+        int begin = d == 0 ? weightedGraph->edgeBegin(v) : weightedGraph->reverseEdgeBegin(v);
+        int end = d == 0 ? weightedGraph->edgeEnd(v) : weightedGraph->reverseEdgeEnd(v);
+        counters.relaxed += end - begin;
+        for (int k = begin; k < end; k++) {
+            int j = d == 0 ? weightedGraph->edgeTarget(k) : weightedGraph->reverseEdgeSource(k);
+            double weight = minWeight + weightedGraph->edgeWeight(d == 0 ? k : weightedGraph->reverseEdgeId(k));
+
+            if (weight < side.workspace.distanceOf(j)) {
+                side.workspace.setDistance(j, weight);
+                heap.push_back(make_pair(weight, j));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    } //end while
+
+    return bestStation;
+} //end cheapestChargingStation
+
+// Function to append the travel path from one location to another to a path, optionally
+// without its last location (when the next leg starts there)
+void EVCharging::appendTravelPath(vector<int>& path, int from, int to, bool dropLast) {
+    EV_TIMER_LEG("travelPath", from, to);
+    static thread_local vector<int> leg;
+    travelPath(from, to, leg);
+    path.insert(path.end(), leg.begin(), leg.end() - (dropLast ? 1 : 0));
+}
+
+// Function to print the costs of a result
+void EVCharging::printCosts(const QueryResult& result) {
+    cout << "Charging cost: $" << result.chargingCost << endl;
+    cout << "Travel cost: $" << result.travelCost << endl;
+    cout << "Total cost: $" << result.chargingCost + result.travelCost << endl;
+}
+
+// Function to print the locations of a path, each followed by a comma
+void EVCharging::printPath(const vector<int>& path) {
+    EV_TIMER("printPath");
+    for (int location : path) {
+        cout << stations.name(location) << ", ";
+    }
 }
+
 //-----------------------------------------------------Task 7-------------------------------------------
+// Function to find the cheapest other station to charge at on a round trip from a location
+QueryResult EVCharging::findOtherCheapestStation(int index, int chargingAmount) {
+    EV_TIMER("findOtherCheapestStation");
+    QueryResult result;
+    result.task = 7;
+
+    // Find the other cheapest charging station and retrieve associated costs
+    int lowestID = cheapestChargingStation(index, index, index, chargingAmount, result.travelCost, result.chargingCost);
+
+    if (lowestID != -1) {
+        result.found = true;
+        result.stations.push_back(lowestID);
+        result.charged.push_back(chargingAmount);
+    }
+    return result;
+}
+
 void EVCharging::cheapestStationOther() {
     // Get user input for the location
     int index = getLocationInput();
@@ -297,28 +1071,45 @@ void EVCharging::cheapestStationOther() {
         return;
     }
 
-    // Randomly generate a charging amount between 10 and 50 kWh
-    int chargingAmount = rand() % 41 + 10;
+    // Draw a charging amount between 10 and 50 kWh (reproducible for a given --seed)
+    int chargingAmount = ChargingAmount::next();
     cout << "Charging amount: " << chargingAmount << " kWh" << endl;
 
-    // Variables to store charging and travel costs
-    double chargingCost, travelCost;
-
-    // Find the other cheapest charging station and retrieve associated costs
-    int lowestID = cheapestChargingStation(index, index, index, chargingAmount, travelCost, chargingCost);
+    EV_TIMER("task 7");
+    QueryResult result = answer({7, index, -1, chargingAmount});
 
     // Display the results based on whether another cheapest charging station was found
-    if (lowestID != -1) {
-        cout << "The other cheapest charging station is " << locations[lowestID].locationName << endl;
-        cout << "Charging cost: $" << chargingCost << endl;
-        cout << "Travel cost: $" << travelCost << endl;
-        cout << "Total cost: $" << chargingCost + travelCost << endl;
+    if (result.found) {
+        cout << "The other cheapest charging station is " << stations.name(result.stations[0]) << endl;
+        printCosts(result);
     } else {
         cout << "No results found!" << endl;
     }
 }
 
 //-----------------------------------------------------Task 8-------------------------------------------
+// Function to find the station where charging on the way from origin to destination costs least
+QueryResult EVCharging::findCheapestChargingPath(int origin, int destination, int chargingAmount) {
+    EV_TIMER("findCheapestChargingPath");
+    QueryResult result;
+    result.task = 8;
+
+    // Find the cheapest charging station and retrieve associated costs
+    int lowestId = cheapestChargingStation(origin, destination, -1, chargingAmount, result.travelCost, result.chargingCost);
+    if (lowestId == -1)
+        return result;
+
+    result.found = true;
+    result.stations.push_back(lowestId);
+    result.charged.push_back(chargingAmount);
+
+    // The travel path from origin to the cheapest charging station, then on to the destination
+    if (lowestId != origin)
+        appendTravelPath(result.path, origin, lowestId, true);
+    appendTravelPath(result.path, lowestId, destination, false);
+    return result;
+}
+
 void EVCharging::cheapestChargingPath() {
     // Get user input for the origin location
     int origin = getLocationInput();
@@ -332,56 +1123,119 @@ void EVCharging::cheapestChargingPath() {
         return;
     }
 
-    // Randomly generate a charging amount between 10 and 50 kWh
-    int chargingAmount = rand() % 41 + 10;
+    // Draw a charging amount between 10 and 50 kWh (reproducible for a given --seed)
+    int chargingAmount = ChargingAmount::next();
     cout << "Charging amount: " << chargingAmount << " kWh" << endl;
 
-    // Variables to store charging and travel costs
-    double chargingCost, travelCost;
-
-    // Find the cheapest charging station and retrieve associated costs
-    int lowestId = cheapestChargingStation(origin, destination, -1, chargingAmount, travelCost, chargingCost);
+    EV_TIMER("task 8");
+    QueryResult result = answer({8, origin, destination, chargingAmount});
 
     // Display the results based on whether the cheapest charging station was found
-    if (lowestId != -1) {
-        cout << "The other cheapest charging station is " << locations[lowestId].locationName << endl;
-        cout << "Charging cost: $" << chargingCost << endl;
-        cout << "Travel cost: $" << travelCost << endl;
-        cout << "Total cost: $" << chargingCost + travelCost << endl;
+    if (result.found) {
+        cout << "The other cheapest charging station is " << stations.name(result.stations[0]) << endl;
+        printCosts(result);
     } else {
         cout << "No results found!" << endl;
     }
 
     // Display the travel path
     cout << "Travel path: ";
+    printPath(result.path);
+    cout << endl << endl;
+}
 
-    // Display the travel path from origin to the other cheapest charging station
-    if (lowestId != origin) {
-        stack<int> path1 = weightedGraph->shortestPath(origin, lowestId);
+//-----------------------------------------------------Task 9-------------------------------------------
 
-        while (path1.size() > 1) {
-            cout << locations[path1.top()].locationName << ", ";
-            path1.pop();
-        }
+/*This function uses the `cheapestChargingStation` method to find the cheapest charging station for two scenarios:
+ * charging 25 kWh and charging a given amount between 10 and 50 kWh. It then compares the costs and recommends the
+ * best charging strategy, considering the availability of free charging for 25 kWh. The result lists the stations
+ * in the order they are visited, with the amount charged at each, and the travel path as it is printed.
+ */
+QueryResult EVCharging::findBestChargingPath(int origin, int destination, int chargingAmount) {
+    EV_TIMER("findBestChargingPath");
+    QueryResult result;
+    result.task = 9;
+
+    // Variables to store charging and travel costs for two scenarios
+    double chargingCost, travelCost;
+    int freeCharging = cheapestChargingStation(origin, destination, -1, 25, travelCost, chargingCost);
+    if (freeCharging == -1)
+        return result;
+
+    // Recommend charging everything at one station
+    if (chargingAmount <= 25 && stations.price(freeCharging) > 0) {
+        int lowestId = cheapestChargingStation(origin, destination, -1, chargingAmount, result.travelCost, result.chargingCost);
+        if (lowestId == -1)
+            return result;
+
+        result.found = true;
+        result.stations.push_back(lowestId);
+        result.charged.push_back(chargingAmount);
+
+        // The travel path from origin to the recommended charging station, then on to the destination
+        if (lowestId != origin)
+            appendTravelPath(result.path, origin, lowestId, true);
+        appendTravelPath(result.path, lowestId, destination, false);
+        return result;
     }
 
-    // Display the travel path from the other cheapest charging station to the destination
-    stack<int> path2 = weightedGraph->shortestPath(lowestId, destination);
-    while (!path2.empty()) {
-        cout << locations[path2.top()].locationName << ", ";
-        path2.pop();
+    // Variables to store charging and travel costs for two charging scenarios
+    double travelCost1 = 0, chargingCost1 = DBL_MAX, travelCost2 = 0, chargingCost2 = DBL_MAX;
+    int lowestIdL = origin, lowestIdR = destination;
+
+    // Find the cheapest charging station for the rest before the free charging station
+    if (freeCharging != origin) {
+        lowestIdL = cheapestChargingStation(origin, freeCharging, freeCharging, chargingAmount - 25, travelCost1, chargingCost1);
     }
 
-    cout << endl << endl;
-}
+    // Calculate the travel cost from the free charging station to the destination
+    travelCost1 = travelCost1 + travelDistance(freeCharging, destination) * 0.1;
 
-//-----------------------------------------------------Task 9-------------------------------------------
+    // Find the cheapest charging station for the rest after the free charging station
+    if (freeCharging != destination) {
+        lowestIdR = cheapestChargingStation(freeCharging, destination, freeCharging, chargingAmount - 25, travelCost2, chargingCost2);
+    }
+
+    // Calculate the travel cost from the origin to the free charging station
+    travelCost2 = travelCost2 + travelDistance(origin, freeCharging) * 0.1;
+
+    if (lowestIdL == -1 && lowestIdR == -1)
+        return result;
+    result.found = true;
+
+    if (lowestIdR == -1 || (lowestIdL != -1 && travelCost1 + chargingCost1 <= travelCost2 + chargingCost2)) {
+        // Charge the rest first, then 25 kWh at the free charging station
+        result.stations = {lowestIdL, freeCharging};
+        result.charged = {(double)chargingAmount - 25, 25};
+        result.chargingCost = chargingCost1;
+        result.travelCost = travelCost1;
+
+        // The travel path from origin to the first station, to the free charging station, then to the destination
+        if (lowestIdL != origin)
+            appendTravelPath(result.path, origin, lowestIdL, true);
+        else
+            result.path.push_back(origin);
+        appendTravelPath(result.path, lowestIdL, freeCharging, false);
+        if (freeCharging != destination)
+            appendTravelPath(result.path, freeCharging, destination, false);
+    } else {
+        // Charge 25 kWh at the free charging station first, then the rest
+        result.freeStationFirst = true;
+        result.stations = {freeCharging, lowestIdR};
+        result.charged = {25, (double)chargingAmount - 25};
+        result.chargingCost = chargingCost2;
+        result.travelCost = travelCost2;
+
+        // The travel path from origin to the free charging station, to the second station, then to the destination
+        if (freeCharging != origin)
+            appendTravelPath(result.path, origin, freeCharging, true);
+        appendTravelPath(result.path, freeCharging, lowestIdR, false);
+        if (lowestIdR != destination)
+            appendTravelPath(result.path, lowestIdR, destination, false);
+    }
+    return result;
+}
 
-/*This function uses the `cheapestChargingStation` method to find the cheapest charging station for two scenarios:
- * charging 25 kWh and charging a random amount between 10 and 50 kWh. It then compares the costs and recommends the
- * best charging strategy, considering the availability of free charging for 25 kWh. The function displays the associated
- * costs and the travel path for the recommended charging scenario.
- */
 void EVCharging::bestChargingPath() {
     // Get user input for the origin location
     int origin = getLocationInput();
@@ -395,153 +1249,168 @@ void EVCharging::bestChargingPath() {
         return;
     }
     
-    // Randomly generate a charging amount between 10 and 50 kWh
-    int chargingAmount = rand() % 41 + 10;
+    // Draw a charging amount between 10 and 50 kWh (reproducible for a given --seed)
+    int chargingAmount = ChargingAmount::next();
     cout << "Charging amount: " << chargingAmount << " kWh" << endl;
-    
-    // Variables to store charging and travel costs for two scenarios
-    double chargingCost, travelCost;
-    int freeCharging = cheapestChargingStation(origin, destination, -1, 25, travelCost, chargingCost);
-    int lowestId = cheapestChargingStation(origin, destination, -1, chargingAmount, travelCost, chargingCost);
-    
+
+    EV_TIMER("task 9");
+    QueryResult result = answer({9, origin, destination, chargingAmount});
+
     // Display the results based on the recommended charging scenario
-    if (chargingAmount <= 25 && locations[freeCharging].chargingPrice > 0) {
-        // Display the recommended scenario for charging 25 kWh
-        if (lowestId != -1) {
-            cout << "The best way of charging is to charge at " << locations[lowestId].locationName << endl;
-            cout << "Charging cost: $" << chargingCost << endl;
-            cout << "Travel cost: $" << travelCost << endl;
-            cout << "Total cost: $" << chargingCost + travelCost << endl;
-        } else {
-            cout << "No results found!" << endl;
-        }
-        
-        // Display the travel path for the recommended scenario
+    if (!result.found) {
+        cout << "No results found!" << endl;
+        cout << "Travel path: ";
+    } else if (result.stations.size() == 1) {
+        // Display the recommended scenario for charging at one station
+        cout << "The best way of charging is to charge at " << stations.name(result.stations[0]) << endl;
+        printCosts(result);
         cout << "Travel path: ";
-        
-        // Display the travel path from origin to the recommended charging station
-        if (lowestId != origin) {
-            stack<int> path1 = weightedGraph->shortestPath(origin, lowestId);
-            
-            while (path1.size() > 1) {
-                cout << locations[path1.top()].locationName << ", ";
-                path1.pop();
-            }
-        }
-        
-        // Display the travel path from the recommended charging station to the destination
-        stack<int> path2 = weightedGraph->shortestPath(lowestId, destination);
-        while (!path2.empty()) {
-            cout << locations[path2.top()].locationName << ", ";
-            path2.pop();
-        }
     } else {
-        // Variables to store charging and travel costs for two charging scenarios
-        double travelCost1, chargingCost1, travelCost2, chargingCost2;
-        int lowestIdL = origin, lowestIdR = destination;
-        
-        // Find the cheapest charging station for charging 25 kWh
-        if (freeCharging != origin) {
-            lowestIdL = cheapestChargingStation(origin, freeCharging, freeCharging, chargingAmount - 25, travelCost1, chargingCost1);
-        } else {
-            travelCost1 = 0;
-            chargingCost1 = DBL_MAX;
-        }
-        
-        // Calculate the travel cost from the free charging station to the destination
-        vector<double> shortestPath = weightedGraph->shortestPath(freeCharging);
-        travelCost1 = travelCost1 + shortestPath[destination] * 0.1;
-        
-        // Find the cheapest charging station for charging the remaining kWh
-        if (freeCharging != destination) {
-            lowestIdR = cheapestChargingStation(freeCharging, destination, freeCharging, chargingAmount - 25, travelCost2, chargingCost2);
-        } else {
-            travelCost2 = 0;
-            chargingCost2 = DBL_MAX;
-        }
-        
-        // Calculate the travel cost from the origin to the free charging station
-        shortestPath = weightedGraph->shortestPath(origin);
-        travelCost2 = travelCost2 + shortestPath[freeCharging] * 0.1;
-        
-        // Display the results based on the recommended charging scenario
+        // Display the recommended scenario for charging at two different locations
         cout << "The best way of charging is " << endl;
-        if (travelCost1 + chargingCost1 <= travelCost2 + chargingCost2) {
-            // Display the recommended scenario for charging at two different locations
-            cout << "Charging " << chargingAmount - 25 << " kWh at " << locations[lowestIdL].locationName << endl;
-            cout << "Charging 25 kWh at " << locations[freeCharging].locationName << endl;
-            cout << "Charging cost: $" << chargingCost1 << endl;
-            cout << "Travel cost: $" << travelCost1 << endl;
-            cout << "Total cost: $" << chargingCost1 + travelCost1 << endl;
-            
-            // Display the travel path for the recommended scenario
-            cout << "Travel path: ";
-            
-            // Display the travel path from origin to the recommended charging station
-            if (lowestIdL != origin) {
-                stack<int> path1 = weightedGraph->shortestPath(origin, lowestIdL);
-                
-                while (path1.size() > 1) {
-                    cout << locations[path1.top()].locationName << ", ";
-                    path1.pop();
-                }
-            } else {
-                cout << locations[origin].locationName << ", ";
-            }
-            
-            // Display the travel path from the recommended charging station to the free charging station
-            stack<int> path2 = weightedGraph->shortestPath(lowestIdL, freeCharging);
-            while (!path2.empty()) {
-                cout << locations[path2.top()].locationName << ", ";
-                path2.pop();
-            }
-            
-            // Display the travel path from the free charging station to the destination
-            if (freeCharging != destination) {
-                stack<int> path3 = weightedGraph->shortestPath(freeCharging, destination);
-                while (!path3.empty()) {
-                    cout << locations[path3.top()].locationName << ", ";
-                    path3.pop();
-                }
-            }
-        } else {
-            // Display the recommended scenario for charging at two different locations
-            cout << "Charging 25 kWh at " << locations[freeCharging].locationName << endl;
-            cout << "Charging " << chargingAmount - 25 << " kWh at " << locations[lowestIdR].locationName << endl;
-            cout << "Charging cost: $" << chargingCost2 << endl;
-            cout << "Travel cost: $" << travelCost2 << endl;
-            cout << "Total cost: $" << chargingCost2 + travelCost2 << endl;
-            
-            // Display the travel path for the recommended scenario
-            cout << "Travel path: " << endl;
-            
-            // Display the travel path from origin to the free charging station
-            if (freeCharging != origin) {
-                stack<int> path1 = weightedGraph->shortestPath(origin, freeCharging);
-                
-                while (path1.size() > 1) {
-                    cout << locations[path1.top()].locationName << ", ";
-                    path1.pop();
-                }
-            }
-            
-            // Display the travel path from the free charging station to the recommended charging station
-            stack<int> path2 = weightedGraph->shortestPath(freeCharging, lowestIdR);
-            while (!path2.empty()) {
-                cout << locations[path2.top()].locationName << ", ";
-                path2.pop();
-            }
-            
-            // Display the travel path from the recommended charging station to the destination
-            if (lowestIdR != destination) {
-                stack<int> path3 = weightedGraph->shortestPath(lowestIdR, destination);
-                while (!path3.empty()) {
-                    cout << locations[path3.top()].locationName << ", ";
-                    path3.pop();
-                }
-            }
+        for (size_t i = 0; i < result.stations.size(); i++) {
+            cout << "Charging " << result.charged[i] << " kWh at " << stations.name(result.stations[i]) << endl;
+        }
+        printCosts(result);
+        cout << "Travel path: ";
+        if (result.freeStationFirst) {
+            cout << endl;
         }
     }
+
+    // Display the travel path for the recommended scenario
+    printPath(result.path);
+    cout << endl << endl;
+}
+
+//-----------------------------------------------------Task 11------------------------------------------
+
+/* This function plans a trip for a vehicle with a real battery: it only drives roads its remaining
+ * charge covers, and stops to charge as often as needed. The interactive task asks for the battery
+ * capacity and the current charge, and uses the default consumption of BatteryProfile.
+ */
+QueryResult EVCharging::findMultiStopPath(int origin, int destination, const BatteryProfile& battery) {
+    EV_TIMER("findMultiStopPath");
+    QueryResult result;
+    result.task = 11;
+
+    ChargingPlan plan = planChargingTrip(origin, destination, battery);
+    if (!plan.found)
+        return result;
+
+    result.found = true;
+    for (const ChargingStop& stop : plan.stops) {
+        result.stations.push_back(stop.location);
+        result.charged.push_back(stop.amount);
+    }
+    result.chargingCost = plan.chargingCost;
+    result.travelCost = plan.travelCost;
+    result.arrivalCharge = plan.arrivalCharge;
+    result.path = plan.path;
+    return result;
+}
+
+void EVCharging::multiStopChargingPath() {
+    // Get user input for the origin location
+    int origin = getLocationInput();
+    if (origin == -1) {
+        return;
+    }
+
+    // Get user input for the destination location
+    int destination = getLocationInput();
+    if (destination == -1) {
+        return;
+    }
+
+    // Get the battery details
+    BatteryProfile battery;
+    cout << "Battery capacity (kWh): ";
+    cin >> battery.capacity;
+    cout << "Current charge (kWh): ";
+    cin >> battery.initialCharge;
+
+    EV_TIMER("task 11");
+    QueryResult result = findMultiStopPath(origin, destination, battery);
+
+    if (!result.found) {
+        cout << "No route to " << stations.name(destination) << " with this battery" << endl << endl;
+        return;
+    }
+
+    // Display the charging stops and the costs
+    for (size_t i = 0; i < result.stations.size(); i++) {
+        cout << "Charging " << result.charged[i] << " kWh at " << stations.name(result.stations[i]) << endl;
+    }
+    printCosts(result);
+    cout << "Charge on arrival: " << result.arrivalCharge << " kWh" << endl;
+
+    // Display the travel path
+    cout << "Travel path: ";
+    printPath(result.path);
     cout << endl << endl;
 }
+
+//-----------------------------------------------------Queries------------------------------------------
+// Function to compute the answer of one query of tasks 4 to 9 and 11 (10 quits the menu)
+QueryResult EVCharging::computeAnswer(const Query& query) {
+    switch (query.task) {
+        case 4:
+            return findAdjacentStations(query.origin);
+        case 5:
+            return findCheapestAdjacentStation(query.origin, query.chargingAmount);
+        case 6:
+            return findNearestStation(query.origin);
+        case 7:
+            return findOtherCheapestStation(query.origin, query.chargingAmount);
+        case 8:
+            return findCheapestChargingPath(query.origin, query.destination, query.chargingAmount);
+        case 9:
+            return findBestChargingPath(query.origin, query.destination, query.chargingAmount);
+        case 11: {
+            BatteryProfile battery;
+            battery.capacity = query.batteryCapacity;
+            battery.initialCharge = query.chargingAmount;
+            return findMultiStopPath(query.origin, query.destination, battery);
+        }
+        default: {
+            QueryResult result;
+            result.task = query.task;
+            return result;
+        }
+    }
+}
+
+// Function to answer one query of tasks 4 to 9 and 11 through the cache
+// Fields the task does not use are cleared from the key, so they cannot split one answer into
+// several entries. The version is read before computing: if the data changes meanwhile, the
+// entry is stored under the old version and is never served
+QueryResult EVCharging::answer(const Query& query) {
+    { lock_guard<mutex> gate(updateGate); }
+    shared_lock<shared_mutex> lock(networkMutex);
+
+    if (query.task < 4 || query.task > 11 || query.task == 10)
+        return computeAnswer(query);
+
+    Query key = query;
+    if (key.task < 8)
+        key.destination = -1;
+    if (key.task == 4 || key.task == 6)
+        key.chargingAmount = 0;
+    if (key.task != 11)
+        key.batteryCapacity = 40;
+
+    uint64_t version = dataVersion;
+    QueryResult result;
+    if (answers.find(key, version, result)) {
+        EV_COUNT(COUNTER_ANSWER_CACHE_HITS, 1);
+        return result;
+    }
+
+    EV_COUNT(COUNTER_ANSWER_CACHE_MISSES, 1);
+    result = computeAnswer(key);
+    size_t bytes = (result.stations.capacity() + result.path.capacity()) * sizeof(int) + result.charged.capacity() * sizeof(double);
+    answers.insert(key, result, version, bytes);
+    return result;
+}
 #endif /* EVCharging_h */
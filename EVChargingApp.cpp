@@ -28,17 +28,113 @@ I hold a copy of this assignment that I can produce if the original is lost or d
 #include <list>
 #include <queue>
 #include <map>
+#include <cctype>
 
 using namespace std;
 
 #include "Location.h"
 #include "WeightedGraph.h"
 #include "EVCharging.h"
+#include "BatchMode.h"
+#include "RoutingServer.h"
+
+int main(int argc, char* argv[]) {
+    // --seed N (allowed anywhere) fixes the made-up charging amounts, so a run can be replayed.
+    // --trace file.json and --stats write the timed spans and print the search counters on exit
+    // (in a build with EV_INSTRUMENTATION). --landmarks K [--landmark-selection farthest|avoid]
+    // preprocesses K ALT landmarks instead of a contraction hierarchy when there is no all-pairs table.
+    // --fixed-point [SCALE] searches the road distances as integer multiples of 1/SCALE (default 10)
+    string traceFileName;
+    bool printStats = false;
+    int landmarkCount = 0;
+    LandmarkSelection landmarkSelection = LANDMARKS_AVOID;
+    int fixedPointScale = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--seed" && i + 1 < argc)
+            ChargingAmount::setSeed(strtoull(argv[++i], nullptr, 10));
+        else if (string(argv[i]) == "--trace" && i + 1 < argc)
+            traceFileName = argv[++i];
+        else if (string(argv[i]) == "--stats")
+            printStats = true;
+        else if (string(argv[i]) == "--landmarks" && i + 1 < argc)
+            landmarkCount = atoi(argv[++i]);
+        else if (string(argv[i]) == "--landmark-selection" && i + 1 < argc)
+            landmarkSelection = string(argv[++i]) == "farthest" ? LANDMARKS_FARTHEST : LANDMARKS_AVOID;
+        else if (string(argv[i]) == "--fixed-point")
+            fixedPointScale = (i + 1 < argc && isdigit((unsigned char)argv[i + 1][0])) ? atoi(argv[++i]) : 10;
+        else
+            argv[kept++] = argv[i];
+    }
+    argc = kept;
+    EVCharging::useLandmarks(landmarkCount, landmarkSelection);
+    EVCharging::useFixedPointWeights(fixedPointScale);
+    InstrumentationExport instrumentation(traceFileName, printStats);
+
+    // Server mode: answer queries from local clients until interrupted. The server owns its
+    // engine so that it can swap in a new one when the input files are reloaded.
+    // Usage: EVChargingApp --serve unix:<path>|tcp:<port> [--threads N] [--json]
+    if (argc > 2 && string(argv[1]) == "--serve") {
+        BatchFormat format = BATCH_TSV;
+        int threads = 0;
+        for (int i = 3; i < argc; i++) {
+            if (string(argv[i]) == "--json")
+                format = BATCH_JSON;
+            else if (string(argv[i]) == "--threads" && i + 1 < argc)
+                threads = atoi(argv[++i]);
+        }
+
+        RoutingServer server(make_shared<EVCharging>(), argv[2], format, threads);
+        return server.run() ? 0 : 1;
+    }
 
-int main() {
     // Create an instance of the EVCharging class
     EVCharging charging;
 
+    // Offline precompute mode: build the all-pairs distance table used by later runs, then exit
+    if (argc > 1 && string(argv[1]) == "--precompute") {
+        if (!charging.precomputeDistances())
+            return 1;
+        cout << "All-pairs distance table written." << endl;
+        return 0;
+    }
+
+    // Snapshot mode: save the parsed input files and the contraction hierarchy in binary form so later runs load faster, then exit
+    if (argc > 1 && string(argv[1]) == "--snapshot") {
+        if (!charging.writeSnapshot())
+            return 1;
+        cout << "Network snapshot written." << endl;
+        return 0;
+    }
+
+    // Batch mode: answer the queries of a file (or stdin) without prompts, one result line each.
+    // Usage: EVChargingApp --batch [queries file] [--json]
+    if (argc > 1 && string(argv[1]) == "--batch") {
+        BatchFormat format = BATCH_TSV;
+        const char* queriesFileName = nullptr;
+        for (int i = 2; i < argc; i++) {
+            if (string(argv[i]) == "--json")
+                format = BATCH_JSON;
+            else
+                queriesFileName = argv[i];
+        }
+
+        FILE* input = stdin;
+        if (queriesFileName != nullptr && string(queriesFileName) != "-") {
+            input = fopen(queriesFileName, "r");
+            if (input == nullptr) {
+                cout << "Cannot open input file." << endl;
+                return 1;
+            }
+        }
+
+        BatchRunner runner(charging, format);
+        runner.run(input, stdout);
+        if (input != stdin)
+            fclose(input);
+        return 0;
+    }
+
     // Variable to store user's menu choice
     int choice = 0;
 
@@ -59,6 +155,7 @@ int main() {
         cout << "8. Find the cheapest charging station between origin and destination " << endl;
         cout << "9. Find the best charging path (multiple charging) " << endl;
         cout << "10. Quit" << endl;
+        cout << "11. Plan a trip with multiple charging stops for a given battery " << endl;
 
         // Get the user's choice
         cin >> choice;
@@ -115,6 +212,11 @@ int main() {
                 cout << "BYE BYE!" << endl;
                 break;
             }
+            // Task 11: Plan a trip with multiple charging stops for a given battery
+            case 11: {
+                charging.multiStopChargingPath();
+                break;
+            }
             // Default case: Display an error message for invalid choices
             default:
                 cout << "Invalid choice. Please choose again." << endl << endl;
@@ -0,0 +1,442 @@
+//
+//  Instrumentation.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef Instrumentation_h
+#define Instrumentation_h
+
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+
+using namespace std;
+
+/* Counters and timers for the hot paths, to see what a slow query spent its time on.
+ * Everything is compiled in only when EV_INSTRUMENTATION is defined (cmake -DEV_INSTRUMENTATION=ON);
+ * otherwise the macros below expand to nothing and SearchCounters is never read, so the
+ * optimiser removes it and the searches run exactly as before.
+ *
+ *     EV_COUNT(counter, amount)    add to one of the Counter values of the calling thread
+ *     EV_TIMER(name)               time the rest of the enclosing block under a name
+ *     EV_TIMER_LEG(name, from, to) the same, recording the two locations of a leg with the span
+ *
+ * Each thread keeps its own counters, timer totals and trace spans, so recording never waits
+ * for another thread. Instrumentation::report() and writeChromeTrace() merge the threads on
+ * demand. A trace span carries the counter changes made inside it, so the trace of a slow
+ * bestChargingPath shows each cheapestChargingStation call and each travel path leg with
+ * the vertices it settled.
+ */
+
+// Work done by the searches, counted per thread
+enum Counter {
+    COUNTER_SEARCHES,            // Searches started
+    COUNTER_VERTICES_SETTLED,    // Vertices (or search states) taken from the queue as final
+    COUNTER_EDGES_RELAXED,       // Edges looked at from a settled vertex
+    COUNTER_HEAP_PUSHES,
+    COUNTER_HEAP_POPS,           // Stale entries included
+    COUNTER_TREE_CACHE_HITS,     // Shortest path trees served from the EVCharging cache
+    COUNTER_TREE_CACHE_MISSES,
+    COUNTER_ANSWER_CACHE_HITS,   // Queries answered from the answer cache
+    COUNTER_ANSWER_CACHE_MISSES,
+    COUNTER_COUNT
+};
+
+static const char* const counterNames[COUNTER_COUNT] = {
+    "searches", "vertices_settled", "edges_relaxed", "heap_pushes", "heap_pops",
+    "tree_cache_hits", "tree_cache_misses", "answer_cache_hits", "answer_cache_misses"
+};
+
+// Calls and time of one named timer
+struct TimerTotals {
+    const char* name;
+    uint64_t calls = 0;
+    uint64_t nanoseconds = 0;
+    uint64_t maxNanoseconds = 0;
+};
+
+// One timed span, as written to the trace
+struct TraceEvent {
+    const char* name;
+    int thread;
+    int from, to;                       // Locations of a leg (-1 if none)
+    uint64_t start, duration;           // Nanoseconds since the program started
+    uint64_t counters[COUNTER_COUNT];   // Counter changes made inside the span
+};
+
+// Counters and timer totals merged over all threads
+struct InstrumentationReport {
+    uint64_t counters[COUNTER_COUNT] = {};
+    vector<TimerTotals> timers;
+    uint64_t droppedEvents = 0;         // Spans not kept because a thread's trace was full
+};
+
+// The statistics of one thread. Only the owning thread writes them; the counters are atomics
+// written with relaxed loads and stores (no locked instructions), so another thread may read
+// them at any time. Timer totals and spans are only touched under the thread's lock
+class ThreadStats {
+public:
+    int thread;
+    atomic<uint64_t> counters[COUNTER_COUNT];
+    mutex timersMutex;
+    vector<TimerTotals> timers;
+    vector<TraceEvent> events;
+    uint64_t droppedEvents = 0;
+
+    ThreadStats(int thread) : thread(thread) {
+        for (atomic<uint64_t>& counter : counters)
+            counter.store(0, memory_order_relaxed);
+    }
+
+    void add(Counter counter, uint64_t amount) {
+        counters[counter].store(counters[counter].load(memory_order_relaxed) + amount, memory_order_relaxed);
+    }
+
+    uint64_t get(Counter counter) const {
+        return counters[counter].load(memory_order_relaxed);
+    }
+
+    // Add one timed call to the totals of a timer (the lock must be held)
+    void addTime(const char* name, uint64_t nanoseconds);
+};
+
+// Class definition for Instrumentation, the registry of every thread's statistics
+class Instrumentation {
+private:
+    static mutex registryMutex;
+    static vector<ThreadStats*> liveThreads;
+    static ThreadStats* finishedThreads;    // Totals of the threads that have exited (never freed, as
+                                            // threads may exit during static destruction)
+    static atomic<int> threadCount;
+    static atomic<bool> tracing;
+
+    // Owns the statistics of one thread and folds them into finishedThreads when it exits
+    struct Holder {
+        ThreadStats* stats;
+        Holder();
+        ~Holder();
+    };
+
+    // Add the totals of one timer to a list, under the same name if it is there already
+    static void addTotals(vector<TimerTotals>& totals, const TimerTotals& timer);
+    static void merge(ThreadStats& stats, InstrumentationReport& report);
+
+public:
+    static const size_t maxEventsPerThread = 1 << 20;
+
+#ifdef EV_INSTRUMENTATION
+    static const bool enabled = true;
+#else
+    static const bool enabled = false;
+#endif
+
+    // Get the statistics of the calling thread
+    static ThreadStats& local() {
+        static thread_local Holder holder;
+        return *holder.stats;
+    }
+
+    static void count(Counter counter, uint64_t amount) {
+        local().add(counter, amount);
+    }
+
+    // Nanoseconds since the first call
+    static uint64_t now() {
+        static const chrono::steady_clock::time_point epoch = chrono::steady_clock::now();
+        return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - epoch).count();
+    }
+
+    // Keep the timed spans for writeChromeTrace (off by default: only the totals are kept)
+    static void setTracing(bool on) {
+        now(); // Start the clock
+        tracing = on;
+    }
+    static bool isTracing() {
+        return tracing.load(memory_order_relaxed);
+    }
+
+    // Get the counters and timer totals of all threads so far
+    static InstrumentationReport report();
+    // Print the report as two tables
+    static void printReport(ostream& out);
+    // Write the spans of all threads in Chrome's trace event format, for chrome://tracing or
+    // ui.perfetto.dev. Returns false if the file cannot be written
+    static bool writeChromeTrace(const char* fileName);
+};
+
+mutex Instrumentation::registryMutex;
+vector<ThreadStats*> Instrumentation::liveThreads;
+ThreadStats* Instrumentation::finishedThreads = new ThreadStats(-1);
+atomic<int> Instrumentation::threadCount(0);
+atomic<bool> Instrumentation::tracing(false);
+
+// Class definition for ScopedTimer, which times the block it is declared in
+class ScopedTimer {
+private:
+    const char* name;
+    int from, to;
+    ThreadStats& stats;
+    uint64_t start;
+    uint64_t countersAtStart[COUNTER_COUNT];
+
+public:
+    ScopedTimer(const char* name, int from = -1, int to = -1)
+        : name(name), from(from), to(to), stats(Instrumentation::local()) {
+        for (int c = 0; c < COUNTER_COUNT; c++)
+            countersAtStart[c] = stats.get((Counter)c);
+        start = Instrumentation::now();
+    }
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+// Class definition for InstrumentationExport, which writes the trace and prints the report when it
+// goes out of scope, so a program gets them on every way out of main. The report goes to cerr,
+// to keep it apart from batch output on cout
+class InstrumentationExport {
+private:
+    string traceFileName;
+    bool printStats;
+
+public:
+    InstrumentationExport(const string& traceFileName, bool printStats)
+        : traceFileName(traceFileName), printStats(printStats) {
+        if (!traceFileName.empty())
+            Instrumentation::setTracing(true);
+    }
+    ~InstrumentationExport();
+};
+
+// Work of one search, kept in locals while it runs and added to the thread's counters once at
+// the end, so the inner loops do not touch shared memory
+struct SearchCounters {
+    uint64_t settled = 0;
+    uint64_t relaxed = 0;
+    uint64_t pushes = 0;
+    uint64_t pops = 0;
+
+#ifdef EV_INSTRUMENTATION
+    ~SearchCounters() {
+        ThreadStats& stats = Instrumentation::local();
+        stats.add(COUNTER_SEARCHES, 1);
+        stats.add(COUNTER_VERTICES_SETTLED, settled);
+        stats.add(COUNTER_EDGES_RELAXED, relaxed);
+        stats.add(COUNTER_HEAP_PUSHES, pushes);
+        stats.add(COUNTER_HEAP_POPS, pops);
+    }
+#endif
+};
+
+#define EV_CONCATENATE_(a, b) a##b
+#define EV_CONCATENATE(a, b) EV_CONCATENATE_(a, b)
+
+#ifdef EV_INSTRUMENTATION
+#define EV_COUNT(counter, amount) Instrumentation::count(counter, amount)
+#define EV_TIMER(name) ScopedTimer EV_CONCATENATE(evTimer, __LINE__)(name)
+#define EV_TIMER_LEG(name, from, to) ScopedTimer EV_CONCATENATE(evTimer, __LINE__)(name, from, to)
+#else
+#define EV_COUNT(counter, amount) ((void)0)
+#define EV_TIMER(name) ((void)0)
+#define EV_TIMER_LEG(name, from, to) ((void)0)
+#endif
+
+
+// Function to add one timed call to a timer
+void ThreadStats::addTime(const char* name, uint64_t nanoseconds) {
+    for (TimerTotals& timer : timers) {
+        if (timer.name == name || strcmp(timer.name, name) == 0) {
+            timer.calls++;
+            timer.nanoseconds += nanoseconds;
+            timer.maxNanoseconds = max(timer.maxNanoseconds, nanoseconds);
+            return;
+        }
+    }
+    TimerTotals timer;
+    timer.name = name;
+    timer.calls = 1;
+    timer.nanoseconds = timer.maxNanoseconds = nanoseconds;
+    timers.push_back(timer);
+}
+
+
+// Function to record the time of a block when it ends
+ScopedTimer::~ScopedTimer() {
+    uint64_t end = Instrumentation::now();
+    lock_guard<mutex> lock(stats.timersMutex);
+    stats.addTime(name, end - start);
+
+    if (!Instrumentation::isTracing())
+        return;
+    if (stats.events.size() >= Instrumentation::maxEventsPerThread) {
+        stats.droppedEvents++;
+        return;
+    }
+    TraceEvent event;
+    event.name = name;
+    event.thread = stats.thread;
+    event.from = from;
+    event.to = to;
+    event.start = start;
+    event.duration = end - start;
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        event.counters[c] = stats.get((Counter)c) - countersAtStart[c];
+    stats.events.push_back(event);
+}
+
+
+// Register a new thread
+Instrumentation::Holder::Holder() : stats(new ThreadStats(threadCount++)) {
+    lock_guard<mutex> lock(registryMutex);
+    liveThreads.push_back(stats);
+}
+
+
+// Fold an exiting thread into the totals of the finished threads
+Instrumentation::Holder::~Holder() {
+    lock_guard<mutex> lock(registryMutex);
+    for (size_t k = 0; k < liveThreads.size(); k++) {
+        if (liveThreads[k] == stats) {
+            liveThreads.erase(liveThreads.begin() + k);
+            break;
+        }
+    }
+
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        finishedThreads->add((Counter)c, stats->get((Counter)c));
+    lock_guard<mutex> timersLock(stats->timersMutex);
+    for (const TimerTotals& timer : stats->timers)
+        addTotals(finishedThreads->timers, timer);
+    finishedThreads->events.insert(finishedThreads->events.end(), stats->events.begin(), stats->events.end());
+    finishedThreads->droppedEvents += stats->droppedEvents;
+    delete stats;
+}
+
+
+// Function to add the totals of one timer to a list of timers
+void Instrumentation::addTotals(vector<TimerTotals>& totals, const TimerTotals& timer) {
+    for (TimerTotals& total : totals) {
+        if (strcmp(total.name, timer.name) == 0) {
+            total.calls += timer.calls;
+            total.nanoseconds += timer.nanoseconds;
+            total.maxNanoseconds = max(total.maxNanoseconds, timer.maxNanoseconds);
+            return;
+        }
+    }
+    totals.push_back(timer);
+}
+
+
+// Function to add the statistics of one thread to a report
+void Instrumentation::merge(ThreadStats& stats, InstrumentationReport& report) {
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        report.counters[c] += stats.get((Counter)c);
+
+    lock_guard<mutex> lock(stats.timersMutex);
+    for (const TimerTotals& timer : stats.timers)
+        addTotals(report.timers, timer);
+    report.droppedEvents += stats.droppedEvents;
+}
+
+
+// Function to merge the statistics of all threads
+InstrumentationReport Instrumentation::report() {
+    InstrumentationReport result;
+    lock_guard<mutex> lock(registryMutex);
+    merge(*finishedThreads, result);
+    for (ThreadStats* stats : liveThreads)
+        merge(*stats, result);
+    return result;
+}
+
+
+// Function to print the merged counters and timers
+void Instrumentation::printReport(ostream& out) {
+    InstrumentationReport totals = report();
+
+    out << left << setw(40) << "Counter" << right << setw(16) << "Total" << endl;
+    for (int c = 0; c < COUNTER_COUNT; c++)
+        out << left << setw(40) << counterNames[c] << right << setw(16) << totals.counters[c] << endl;
+
+    out << endl << left << setw(40) << "Timer" << right << setw(12) << "Calls" << setw(14) << "Total ms"
+        << setw(14) << "Mean us" << setw(14) << "Max us" << endl;
+    for (const TimerTotals& timer : totals.timers) {
+        out << left << setw(40) << timer.name << right << setw(12) << timer.calls << fixed << setprecision(3)
+            << setw(14) << timer.nanoseconds / 1e6 << setw(14) << timer.nanoseconds / 1e3 / timer.calls
+            << setw(14) << timer.maxNanoseconds / 1e3 << endl;
+        out.unsetf(ios::floatfield);
+    }
+    if (totals.droppedEvents > 0)
+        out << totals.droppedEvents << " trace spans were dropped (trace full)" << endl;
+}
+
+
+// Function to write the spans of all threads as Chrome trace events
+// Each span is a complete event ("ph":"X") with its times in microseconds; its leg and the
+// counters that changed inside it are the event's args
+bool Instrumentation::writeChromeTrace(const char* fileName) {
+    FILE* file = fopen(fileName, "w");
+    if (file == nullptr) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+
+    lock_guard<mutex> lock(registryMutex);
+    vector<ThreadStats*> sources(liveThreads);
+    sources.push_back(finishedThreads);
+
+    fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", file);
+    bool first = true;
+    for (int thread = 0; thread < threadCount; thread++) {
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+                first ? "" : ",\n", thread, thread);
+        first = false;
+    }
+    for (ThreadStats* stats : sources) {
+        lock_guard<mutex> timersLock(stats->timersMutex);
+        for (const TraceEvent& event : stats->events) {
+            fprintf(file, "%s{\"name\":\"%s\",\"cat\":\"ev\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,\"args\":{",
+                    first ? "" : ",\n", event.name, event.thread, event.start / 1e3, event.duration / 1e3);
+            first = false;
+
+            const char* separator = "";
+            if (event.from != -1) {
+                fprintf(file, "\"from\":%d,\"to\":%d", event.from, event.to);
+                separator = ",";
+            }
+            for (int c = 0; c < COUNTER_COUNT; c++) {
+                if (event.counters[c] != 0) {
+                    fprintf(file, "%s\"%s\":%llu", separator, counterNames[c], (unsigned long long)event.counters[c]);
+                    separator = ",";
+                }
+            }
+            fputs("}}", file);
+        }
+    }
+    fputs("\n]}\n", file);
+    return fclose(file) == 0;
+}
+
+// Function to write the trace and print the report
+InstrumentationExport::~InstrumentationExport() {
+    if (traceFileName.empty() && !printStats)
+        return;
+    if (!Instrumentation::enabled)
+        cerr << "Built without EV_INSTRUMENTATION: nothing was recorded." << endl;
+    if (printStats)
+        Instrumentation::printReport(cerr);
+    if (!traceFileName.empty())
+        Instrumentation::writeChromeTrace(traceFileName.c_str());
+}
+
+#endif /* Instrumentation_h */
@@ -0,0 +1,276 @@
+//
+//  Landmarks.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef Landmarks_h
+#define Landmarks_h
+
+#include <vector>
+#include <cmath>
+#include <cfloat>
+#include <random>
+#include <algorithm>
+
+#include "WeightedGraph.h"
+
+using namespace std;
+
+// How LandmarkIndex chooses its landmarks
+enum LandmarkSelection {
+    LANDMARKS_FARTHEST, // Each landmark is the vertex farthest from the landmarks chosen so far
+    LANDMARKS_AVOID     // Each landmark sits at the end of the branch of a search tree the landmarks so far bound worst
+};
+
+// Class definition for LandmarkIndex, the preprocessing of A* with landmarks and the triangle
+// inequality (ALT), for graphs without coordinates. For a landmark L and any u, t the triangle
+// inequality gives two lower bounds of the distance d(u, t):
+//     d(L, t) - d(L, u)    and    d(u, L) - d(t, L)
+// so one search from and one search to every landmark, done once, give a lower bound between
+// any two vertices. Roads may be one-way, which is why both directions are kept.
+// Distances are stored as floats, one row of k per vertex for each direction, so a bound reads
+// two short contiguous rows. A bound is lowered by the most the float rounding can have added.
+// The bounds stay valid while road distances only grow; after any road gets shorter the index
+// must be built again
+class LandmarkIndex {
+private:
+    WeightedGraphType* graph = nullptr;
+    int vertexCount = 0;
+    int landmarkCount = 0;
+    vector<int> landmarks;
+    vector<float> fromLandmark; // d(landmark i, v) at [v * landmarkCount + i] (infinity if unreachable)
+    vector<float> toLandmark;   // d(v, landmark i) at the same position
+    double slack = 0;           // Largest error the float rounding can put into a bound
+
+    // Get the landmark bound of the distance from u to t over the first count landmarks,
+    // infinity if t cannot be reached from u
+    double lowerBound(int u, int t, int count) const;
+    // Choose the next landmark: the vertex whose nearest landmark (there and back) is the farthest
+    int farthestVertex(const vector<double>& closest, int start, const ShortestPathTree& startTree) const;
+    // Choose the next landmark: grow a shortest path tree from root, weigh every vertex by how
+    // much the landmarks so far underestimate its distance from root, and follow the heaviest
+    // branch without a landmark down to a leaf
+    int avoidVertex(int root, const ShortestPathTree& rootTree, const vector<bool>& isLandmark) const;
+
+public:
+    // Choose count landmarks of the graph and search from and to each of them. The graph must
+    // outlive the index. Returns false if count is not positive or the graph is empty
+    bool build(WeightedGraphType& graph, int count, LandmarkSelection selection = LANDMARKS_AVOID, unsigned seed = 1);
+
+    // Check whether build has succeeded
+    bool isBuilt() const {
+        return landmarkCount > 0;
+    }
+    // Get the number of landmarks
+    int size() const {
+        return landmarkCount;
+    }
+    // Get the landmark vertices, in the order they were chosen
+    const vector<int>& getLandmarks() const {
+        return landmarks;
+    }
+    // Get the memory one landmark takes: a float each way for every vertex
+    size_t bytesPerLandmark() const {
+        return 2 * (size_t)vertexCount * sizeof(float);
+    }
+
+    // Get a lower bound on the distance from u to t (infinity if t cannot be reached from u)
+    double lowerBound(int u, int t) const {
+        return lowerBound(u, t, landmarkCount);
+    }
+
+    // Find the shortest path from origin to destination with an A* search guided by the
+    // landmarks, as WeightedGraphType::shortestPath(origin, destination, path) does
+    double shortestPath(int origin, int destination, vector<int>& path) const;
+};
+
+
+// Function to get the lower bound over the first count landmarks
+// Both rows are read front to back; a difference of two infinities is NaN, which max ignores
+double LandmarkIndex::lowerBound(int u, int t, int count) const {
+    const float* fromU = &fromLandmark[(size_t)u * landmarkCount];
+    const float* toU = &toLandmark[(size_t)u * landmarkCount];
+    const float* fromT = &fromLandmark[(size_t)t * landmarkCount];
+    const float* toT = &toLandmark[(size_t)t * landmarkCount];
+
+    float best = 0;
+    for (int i = 0; i < count; i++) {
+        best = max(best, fromT[i] - fromU[i]);
+        best = max(best, toU[i] - toT[i]);
+    }
+    return max(0.0, best - slack);
+}
+
+
+// Function to choose the vertex farthest from the landmarks so far
+// closest holds, for every vertex, the smallest d(L, v) + d(v, L) over the landmarks so far.
+// The first landmark is the vertex farthest from start instead. Vertices the landmarks cannot
+// reach both ways are left out, unless no other vertex is left
+int LandmarkIndex::farthestVertex(const vector<double>& closest, int start, const ShortestPathTree& startTree) const {
+    int best = -1;
+    double bestDistance = -1;
+    for (int v = 0; v < vertexCount; v++) {
+        double distance = landmarks.empty() ? startTree.distance[v] : closest[v];
+        if (distance < DBL_MAX && distance > bestDistance) {
+            best = v;
+            bestDistance = distance;
+        }
+    }
+    if (bestDistance > 0)
+        return best;
+
+    // Everything reachable is covered: take the lowest vertex that is not a landmark yet
+    for (int v = 0; v < vertexCount; v++) {
+        if (find(landmarks.begin(), landmarks.end(), v) == landmarks.end())
+            return v;
+    }
+    return start;
+}
+
+
+// Function to choose the vertex at the end of the worst bounded branch (Goldberg and Werneck)
+// A vertex weighs d(root, v) minus its landmark bound from root, a branch the sum of its
+// weights; branches that already hold a landmark weigh nothing
+int LandmarkIndex::avoidVertex(int root, const ShortestPathTree& rootTree, const vector<bool>& isLandmark) const {
+    // Reached vertices, farthest first, so every vertex comes before its parent
+    vector<int> order;
+    for (int v = 0; v < vertexCount; v++) {
+        if (rootTree.reachable(v))
+            order.push_back(v);
+    }
+    sort(order.begin(), order.end(), [&](int a, int b) {
+        return rootTree.distance[a] > rootTree.distance[b];
+    });
+
+    // Sum the weights up the tree, and mark the branches holding a landmark
+    vector<double> branchWeight(vertexCount, 0);
+    vector<bool> covered(isLandmark);
+    vector<int> childCount(vertexCount + 1, 0);
+    for (int v : order) {
+        double bound = lowerBound(root, v, (int)landmarks.size());
+        branchWeight[v] += rootTree.distance[v] - min(bound, rootTree.distance[v]);
+        int parent = rootTree.predecessor[v];
+        if (parent != -1) {
+            branchWeight[parent] += branchWeight[v];
+            if (covered[v])
+                covered[parent] = true;
+            childCount[parent + 1]++;
+        }
+    }
+
+    // Children of every vertex, in compressed rows
+    for (int v = 0; v < vertexCount; v++)
+        childCount[v + 1] += childCount[v];
+    vector<int> children(childCount[vertexCount]);
+    vector<int> next(childCount.begin(), childCount.end() - 1);
+    for (int v : order) {
+        if (rootTree.predecessor[v] != -1)
+            children[next[rootTree.predecessor[v]]++] = v;
+    }
+
+    // Start at the heaviest uncovered branch and follow the heaviest uncovered child down to a leaf
+    int v = -1;
+    for (int u : order) {
+        if (!covered[u] && (v == -1 || branchWeight[u] > branchWeight[v]))
+            v = u;
+    }
+    if (v == -1)
+        return -1;
+    while (true) {
+        int heaviest = -1;
+        for (int k = childCount[v]; k < childCount[v + 1]; k++) {
+            int child = children[k];
+            if (!covered[child] && (heaviest == -1 || branchWeight[child] > branchWeight[heaviest]))
+                heaviest = child;
+        }
+        if (heaviest == -1)
+            return v;
+        v = heaviest;
+    }
+}
+
+
+// Function to choose the landmarks and store the distances from and to each of them
+// Landmarks are chosen one at a time, each from the distances of the ones before it, so the
+// 2k searches run one after another. A selection that finds nothing left to cover falls back
+// to the farthest vertex
+bool LandmarkIndex::build(WeightedGraphType& graph, int count, LandmarkSelection selection, unsigned seed) {
+    int n = graph.getNumberOfVertices();
+    if (count <= 0 || n == 0)
+        return false;
+    count = min(count, n);
+
+    this->graph = &graph;
+    vertexCount = n;
+    landmarkCount = count;
+    landmarks.clear();
+    fromLandmark.assign((size_t)n * count, INFINITY);
+    toLandmark.assign((size_t)n * count, INFINITY);
+    slack = 0;
+
+    mt19937 generator(seed);
+    ShortestPathTree forward, backward, rootTree;
+    DijkstraWorkspace workspace;
+    vector<bool> isLandmark(n, false);
+    vector<double> closest(n, DBL_MAX);
+    double largest = 0;
+
+    int start = generator() % n;
+    graph.shortestPathTree(start, rootTree, workspace);
+
+    for (int i = 0; i < count; i++) {
+        int landmark = -1;
+        if (selection == LANDMARKS_AVOID) {
+            int root = generator() % n;
+            graph.shortestPathTree(root, rootTree, workspace);
+            landmark = avoidVertex(root, rootTree, isLandmark);
+        }
+        if (landmark == -1)
+            landmark = farthestVertex(closest, start, rootTree);
+
+        graph.shortestPathTree(landmark, forward, workspace);
+        graph.reverseShortestPathTree(landmark, backward, workspace);
+        landmarks.push_back(landmark);
+        isLandmark[landmark] = true;
+
+        // Only this landmark's column is written; lowerBound reads the first i + 1 landmarks
+        for (int v = 0; v < n; v++) {
+            double from = forward.distance[v], to = backward.distance[v];
+            if (from < DBL_MAX) {
+                fromLandmark[(size_t)v * count + i] = (float)from;
+                largest = max(largest, from);
+            }
+            if (to < DBL_MAX) {
+                toLandmark[(size_t)v * count + i] = (float)to;
+                largest = max(largest, to);
+            }
+            if (from < DBL_MAX && to < DBL_MAX)
+                closest[v] = min(closest[v], from + to);
+        }
+
+        // Rounding to float moves each distance by at most 2^-24 of it, and the subtraction in
+        // lowerBound adds as much again; 2^-22 of the largest distance covers all of it
+        slack = ldexp(largest, -22);
+    }
+    return true;
+} //end build
+
+
+// Function to find the shortest path between two vertices using the landmark bounds
+// The landmark rows of the destination are the same for every vertex, so they stay in cache
+double LandmarkIndex::shortestPath(int origin, int destination, vector<int>& path) const {
+    EV_TIMER_LEG("shortestPath ALT", origin, destination);
+    path.clear();
+
+    // An infinite bound means no path exists, which the landmarks can tell without searching
+    if (lowerBound(origin, destination) == INFINITY)
+        return DBL_MAX;
+
+    return graph->shortestPathGuided(origin, destination, path, [&](int v) {
+        return lowerBound(v, destination, landmarkCount);
+    });
+} //end shortestPath
+
+#endif /* Landmarks_h */
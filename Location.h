@@ -8,6 +8,13 @@
 #ifndef Location_h
 #define Location_h
 
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <cmath>
+
+using namespace std;
+
 // Class definition for Location, representing a charging station
 class Location {
 public:
@@ -16,6 +23,8 @@ public:
     string locationName; // Name of the charging station
     bool chargerInstalled; // Indicates whether a charger is installed at the location
     double chargingPrice;  // Charging price per kilowatt-hour
+    double latitude = NAN;  // Position in degrees (NaN if the input gives none)
+    double longitude = NAN;
 
     // Method to print location information
     void printLocation() {
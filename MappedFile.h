@@ -0,0 +1,138 @@
+//
+//  MappedFile.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef MappedFile_h
+#define MappedFile_h
+
+#include <cstddef>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Class definition for MappedFile, a file mapped into memory with mmap.
+// The mapping is released when the object is destroyed
+class MappedFile {
+private:
+    char* bytes;  // Start of the mapping (nullptr if nothing is mapped)
+    size_t size;  // Length of the mapping in bytes
+
+public:
+    MappedFile() : bytes(nullptr), size(0) {}
+    ~MappedFile() {
+        close();
+    }
+
+    // A mapping cannot be copied, only moved
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) : bytes(other.bytes), size(other.size) {
+        other.bytes = nullptr;
+        other.size = 0;
+    }
+    MappedFile& operator=(MappedFile&& other) {
+        if (this != &other) {
+            close();
+            bytes = other.bytes;
+            size = other.size;
+            other.bytes = nullptr;
+            other.size = 0;
+        }
+        return *this;
+    }
+
+    // Map an existing file read-only. Returns false if it cannot be opened or is empty
+    bool openReadOnly(const char* fileName) {
+        close();
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd); // The mapping stays valid after the descriptor is closed
+        if (mapping == MAP_FAILED)
+            return false;
+
+        bytes = (char*)mapping;
+        size = (size_t)info.st_size;
+        return true;
+    }
+
+    // Create (or truncate) a file of the given size and map it for writing
+    bool create(const char* fileName, size_t length) {
+        close();
+        int fd = ::open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+
+        if (length == 0 || ftruncate(fd, (off_t)length) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        void* mapping = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+            return false;
+
+        bytes = (char*)mapping;
+        size = length;
+        return true;
+    }
+
+    // Flush a writable mapping to disk
+    bool flush() {
+        return bytes == nullptr || msync(bytes, size, MS_SYNC) == 0;
+    }
+
+    // Release the mapping
+    void close() {
+        if (bytes != nullptr)
+            munmap(bytes, size);
+        bytes = nullptr;
+        size = 0;
+    }
+
+    bool isOpen() const {
+        return bytes != nullptr;
+    }
+    const char* data() const {
+        return bytes;
+    }
+    char* data() {
+        return bytes;
+    }
+    size_t length() const {
+        return size;
+    }
+};
+
+// Compute the 64-bit FNV-1a hash of a block of bytes, continuing from a previous hash
+inline uint64_t fnv1aHash(const char* bytes, size_t length, uint64_t hash = 14695981039346656037ULL) {
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Compute the FNV-1a checksum of a whole file (0 if it cannot be read)
+inline uint64_t fileChecksum(const char* fileName) {
+    MappedFile file;
+    if (!file.openReadOnly(fileName))
+        return 0;
+    return fnv1aHash(file.data(), file.length());
+}
+
+#endif /* MappedFile_h */
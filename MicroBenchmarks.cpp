@@ -0,0 +1,474 @@
+//
+//  MicroBenchmarks.cpp
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+//  Build: cmake -S . -B build && cmake --build build
+//  Run:   ./build/MicroBenchmarks [--sizes=100,10000,1000000] [--benchmark_filter=text]
+//                                 [--benchmark_out=results.json] [--benchmark_format=json]
+//
+//  Every WeightedGraphType, ContractionHierarchy, LandmarkIndex and EVCharging operation on synthetic
+//  planar road networks of each size. The networks are written by RoadNetworkGenerator into
+//  BenchmarkNetworks/ and loaded through the same text readers as the sample files
+//
+
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <memory>
+#include <random>
+#include <sys/stat.h>
+
+using namespace std;
+
+#include "WeightedGraph.h"
+#include "ContractionHierarchy.h"
+#include "Landmarks.h"
+#include "EVCharging.h"
+#include "RoadNetworkGenerator.h"
+#include "BenchmarkHarness.h"
+
+// The network of the size being benchmarked, shared by the benchmarks of that size. The
+// load and build benchmarks hand their last result over, so nothing is built twice
+struct NetworkFixture {
+    long size = 0;
+    string weightsFileName;
+    string locationsFileName;
+    unique_ptr<WeightedGraphType> graph;
+    unique_ptr<ContractionHierarchy> hierarchy;
+    unique_ptr<LandmarkIndex> landmarks;
+    unique_ptr<EVCharging> charging;
+    vector<bool> isCharger;           // Charger flags, for the WeightedGraphType target searches
+    vector<double> latitudes;         // Positions, for the A* searches
+    vector<double> longitudes;
+    vector<pair<int, int>> trips;     // Random (origin, destination) pairs, used in turn
+};
+
+NetworkFixture fixture;
+
+// Make the fixture hold the network of the given size, generating its files on first use
+NetworkFixture& networkOfSize(long size) {
+    if (fixture.size == size)
+        return fixture;
+
+    fixture.hierarchy.reset();
+    fixture.landmarks.reset();
+    fixture.charging.reset();
+    fixture.graph.reset();
+    fixture.size = size;
+
+    mkdir("BenchmarkNetworks", 0755);
+    fixture.weightsFileName = "BenchmarkNetworks/Weights" + to_string(size) + ".txt";
+    fixture.locationsFileName = "BenchmarkNetworks/Locations" + to_string(size) + ".txt";
+    RoadNetworkOptions options;
+    options.locations = (int)size;
+    RoadNetworkGenerator::write(options, fixture.weightsFileName.c_str(), fixture.locationsFileName.c_str());
+
+    // Read the charger flags and positions back for the WeightedGraphType searches
+    fixture.isCharger.assign(size, false);
+    fixture.latitudes.assign(size, NAN);
+    fixture.longitudes.assign(size, NAN);
+    FILE* locations = fopen(fixture.locationsFileName.c_str(), "r");
+    char line[256];
+    for (long v = 0; locations != nullptr && v < size && fgets(line, sizeof(line), locations) != nullptr; v++) {
+        fixture.isCharger[v] = strstr(line, ",1,") != nullptr;
+        char* latitude = strchr(strchr(strchr(line, ',') + 1, ',') + 1, ',') + 1;
+        fixture.latitudes[v] = strtod(latitude, nullptr);
+        fixture.longitudes[v] = strtod(strchr(latitude, ',') + 1, nullptr);
+    }
+    if (locations != nullptr)
+        fclose(locations);
+
+    mt19937 generator(42);
+    fixture.trips.resize(4096);
+    for (pair<int, int>& trip : fixture.trips)
+        trip = { (int)(generator() % size), (int)(generator() % size) };
+    return fixture;
+}
+
+// Get the fixture's graph, loading it if no load benchmark has run
+WeightedGraphType& fixtureGraph(NetworkFixture& network) {
+    if (!network.graph)
+        network.graph.reset(new WeightedGraphType((int)network.size, network.weightsFileName.c_str(), EDGE_LIST));
+    if (!network.graph->hasCoordinates())
+        network.graph->setCoordinates(network.latitudes, network.longitudes);
+    return *network.graph;
+}
+
+// Get the fixture's engine, loading it if no load benchmark has run
+EVCharging& fixtureEngine(NetworkFixture& network) {
+    if (!network.charging)
+        network.charging.reset(new EVCharging(network.locationsFileName, network.weightsFileName, EDGE_LIST));
+    return *network.charging;
+}
+
+// Add the benchmarks of the graph layer
+void addGraphBenchmarks(BenchmarkSuite& suite) {
+    suite.add("RoadNetworkGenerator/write", [](BenchmarkState& state) {
+        networkOfSize(state.range());
+        RoadNetworkOptions options;
+        options.locations = (int)state.range();
+        string weights = "BenchmarkNetworks/GeneratorWeights.txt", locations = "BenchmarkNetworks/GeneratorLocations.txt";
+        while (state.keepRunning())
+            RoadNetworkGenerator::write(options, weights.c_str(), locations.c_str());
+        remove(weights.c_str());
+        remove(locations.c_str());
+        state.setItemsProcessed(state.getIterations() * state.range());
+    });
+
+    suite.add("WeightedGraph/load", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        while (state.keepRunning())
+            network.graph.reset(new WeightedGraphType((int)network.size, network.weightsFileName.c_str(), EDGE_LIST));
+        state.counter("edges", network.graph->getNumberOfEdges());
+    });
+
+    suite.add("WeightedGraph/shortestPathTree", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        while (state.keepRunning())
+            doNotOptimize(graph.shortestPathTree(network.trips[k++ % network.trips.size()].first));
+    });
+
+    suite.add("WeightedGraph/shortestPathTree (reused workspace)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        ShortestPathTree tree;
+        DijkstraWorkspace workspace;
+        long k = 0;
+        while (state.keepRunning())
+            graph.shortestPathTree(network.trips[k++ % network.trips.size()].first, tree, workspace);
+    });
+
+    // The same trees over the road distances in tenths of a km, with the bucket queues
+    suite.add("WeightedGraph/shortestPathTreeFixed (radix heap)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        if (!graph.hasFixedPointWeights())
+            graph.useFixedPointWeights(10);
+        ShortestPathTree tree;
+        long k = 0;
+        while (state.keepRunning())
+            graph.shortestPathTreeFixed<RadixHeapQueue>(network.trips[k++ % network.trips.size()].first, tree);
+    });
+
+    suite.add("WeightedGraph/shortestPathTreeFixed (Dial)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        if (!graph.hasFixedPointWeights())
+            graph.useFixedPointWeights(10);
+        ShortestPathTree tree;
+        long k = 0;
+        while (state.keepRunning())
+            graph.shortestPathTreeFixed<DialQueue>(network.trips[k++ % network.trips.size()].first, tree);
+    });
+
+    suite.add("WeightedGraph/shortestPath (distances)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        while (state.keepRunning())
+            doNotOptimize(graph.shortestPath(network.trips[k++ % network.trips.size()].first));
+    });
+
+    suite.add("WeightedGraph/shortestPathDense", [](BenchmarkState& state) {
+        if (state.range() > 10000) {
+            state.skip("O(V^2) reference scan");
+            return;
+        }
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        while (state.keepRunning())
+            graph.shortestPathDense(network.trips[k++ % network.trips.size()].first);
+    });
+
+    // Point-to-point searches without and with the A* lower bound; settled is the average
+    // number of vertices each query settled
+    suite.add("WeightedGraph/shortestPathDijkstra (point to point)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        vector<int> path;
+        long k = 0, settled = 0;
+        while (state.keepRunning()) {
+            const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+            graph.shortestPathDijkstra(trip.first, trip.second, path);
+            settled += WeightedGraphType::lastSearchSettled();
+        }
+        state.counter("settled", (double)settled / state.getIterations());
+    });
+
+    suite.add("WeightedGraph/shortestPathBidirectional (point to point)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        vector<int> path;
+        long k = 0, settled = 0;
+        while (state.keepRunning()) {
+            const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+            graph.shortestPathBidirectional(trip.first, trip.second, path);
+            settled += WeightedGraphType::lastSearchSettled();
+        }
+        state.counter("settled", (double)settled / state.getIterations());
+    });
+
+    suite.add("WeightedGraph/shortestPath (point to point, A*)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        vector<int> path;
+        long k = 0, settled = 0;
+        while (state.keepRunning()) {
+            const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+            graph.shortestPath(trip.first, trip.second, path);
+            settled += WeightedGraphType::lastSearchSettled();
+        }
+        state.counter("settled", (double)settled / state.getIterations());
+    });
+
+    suite.add("WeightedGraph/shortestPaths (8 sources)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        vector<int> sources;
+        for (int s = 0; s < 8; s++)
+            sources.push_back(network.trips[s].first);
+        vector<ShortestPathTree> trees;
+        while (state.keepRunning())
+            graph.shortestPaths(sources, trees);
+        state.setItemsProcessed(state.getIterations() * 8);
+    });
+
+    suite.add("WeightedGraph/nearestTarget", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        double distance;
+        while (state.keepRunning())
+            graph.nearestTarget(network.trips[k++ % network.trips.size()].first, network.isCharger, distance);
+    });
+
+    suite.add("WeightedGraph/nearestTargets (k=5)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        while (state.keepRunning())
+            graph.nearestTargets(network.trips[k++ % network.trips.size()].first, network.isCharger, 5);
+    });
+
+    suite.add("WeightedGraph/getWeight", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        long k = 0;
+        while (state.keepRunning()) {
+            int v = network.trips[k++ % network.trips.size()].first;
+            if (graph.edgeBegin(v) < graph.edgeEnd(v))
+                doNotOptimize(graph.getWeight(v, graph.edgeTarget(graph.edgeBegin(v))));
+        }
+    });
+
+    // One road is made three times longer and back again per iteration, with a cached tree repaired each time
+    suite.add("WeightedGraph/updateEdgeWeight + repair", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        int source = network.trips[0].first;
+        ShortestPathTree tree = graph.shortestPathTree(source);
+        long k = 0;
+        while (state.keepRunning()) {
+            int from = network.trips[k++ % network.trips.size()].second;
+            if (graph.edgeBegin(from) == graph.edgeEnd(from))
+                continue;
+            int to = graph.edgeTarget(graph.edgeBegin(from));
+            double weight = graph.getWeight(from, to);
+            graph.updateEdgeWeight(from, to, weight * 3);
+            graph.repairShortestPathTree(tree, from, to, weight);
+            graph.updateEdgeWeight(from, to, weight);
+            graph.repairShortestPathTree(tree, from, to, weight * 3);
+        }
+    });
+
+    suite.add("ContractionHierarchy/build", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        WeightedGraphType& graph = fixtureGraph(network);
+        while (state.keepRunning()) {
+            network.hierarchy.reset();
+            network.hierarchy.reset(new ContractionHierarchy(graph));
+        }
+        state.counter("shortcuts", network.hierarchy->getShortcutCount());
+    });
+
+    suite.add("ContractionHierarchy/shortestPath", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        if (!network.hierarchy)
+            network.hierarchy.reset(new ContractionHierarchy(fixtureGraph(network)));
+        vector<int> path;
+        long k = 0;
+        while (state.keepRunning()) {
+            const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+            network.hierarchy->shortestPath(trip.first, trip.second, path);
+        }
+    });
+
+    for (LandmarkSelection selection : {LANDMARKS_FARTHEST, LANDMARKS_AVOID}) {
+        string name = selection == LANDMARKS_FARTHEST ? "farthest" : "avoid";
+        suite.add("LandmarkIndex/build (k=16, " + name + ")", [selection](BenchmarkState& state) {
+            NetworkFixture& network = networkOfSize(state.range());
+            WeightedGraphType& graph = fixtureGraph(network);
+            while (state.keepRunning()) {
+                network.landmarks.reset(new LandmarkIndex());
+                network.landmarks->build(graph, 16, selection);
+            }
+            state.counter("bytes_per_landmark", (double)network.landmarks->bytesPerLandmark());
+        });
+    }
+
+    suite.add("LandmarkIndex/shortestPath (ALT, k=16)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        if (!network.landmarks) {
+            network.landmarks.reset(new LandmarkIndex());
+            network.landmarks->build(fixtureGraph(network), 16);
+        }
+        vector<int> path;
+        long k = 0, settled = 0;
+        while (state.keepRunning()) {
+            const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+            network.landmarks->shortestPath(trip.first, trip.second, path);
+            settled += WeightedGraphType::lastSearchSettled();
+        }
+        state.counter("settled", (double)settled / state.getIterations());
+    });
+}
+
+// Add the benchmarks of the EVCharging tasks
+void addChargingBenchmarks(BenchmarkSuite& suite) {
+    suite.add("EVCharging/load", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        // The graph and hierarchy of the graph benchmarks are not needed any more
+        network.hierarchy.reset();
+        network.graph.reset();
+        while (state.keepRunning()) {
+            network.charging.reset();
+            network.charging.reset(new EVCharging(network.locationsFileName, network.weightsFileName, EDGE_LIST));
+        }
+    });
+
+    // The find function of each task on a stream of random trips (tasks 5 to 9 charge 30 kWh)
+    struct Task {
+        const char* name;
+        int task;
+    };
+    static const Task tasks[] = {
+        { "EVCharging/findAdjacentStations", 4 },
+        { "EVCharging/findCheapestAdjacentStation", 5 },
+        { "EVCharging/findNearestStation", 6 },
+        { "EVCharging/findOtherCheapestStation", 7 },
+        { "EVCharging/findCheapestChargingPath", 8 },
+        { "EVCharging/findBestChargingPath", 9 },
+        { "EVCharging/findMultiStopPath", 11 },
+    };
+    for (const Task& task : tasks) {
+        int number = task.task;
+        suite.add(task.name, [number](BenchmarkState& state) {
+            NetworkFixture& network = networkOfSize(state.range());
+            EVCharging& charging = fixtureEngine(network);
+            BatteryProfile battery;
+            long k = 0, found = 0;
+            while (state.keepRunning()) {
+                const pair<int, int>& trip = network.trips[k++ % network.trips.size()];
+                QueryResult result;
+                switch (number) {
+                    case 4: result = charging.findAdjacentStations(trip.first); break;
+                    case 5: result = charging.findCheapestAdjacentStation(trip.first, 30); break;
+                    case 6: result = charging.findNearestStation(trip.first); break;
+                    case 7: result = charging.findOtherCheapestStation(trip.first, 30); break;
+                    case 8: result = charging.findCheapestChargingPath(trip.first, trip.second, 30); break;
+                    case 9: result = charging.findBestChargingPath(trip.first, trip.second, 30); break;
+                    default: result = charging.findMultiStopPath(trip.first, trip.second, battery); break;
+                }
+                found += result.found;
+            }
+            state.counter("found", (double)found / state.getIterations());
+        });
+    }
+
+    suite.add("EVCharging/answer (cache hit)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        Query query;
+        query.task = 8;
+        query.origin = network.trips[0].first;
+        query.destination = network.trips[0].second;
+        query.chargingAmount = 30;
+        charging.answer(query);
+        while (state.keepRunning())
+            charging.answer(query);
+    });
+
+    suite.add("EVCharging/findLocation", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        vector<string> names;
+        for (int k = 0; k < 256; k++)
+            names.push_back("Location " + to_string(network.trips[k].first));
+        long k = 0;
+        while (state.keepRunning())
+            doNotOptimize(charging.findLocation(names[k++ % names.size()]));
+    });
+
+    suite.add("EVCharging/completeLocationName", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        long k = 0;
+        while (state.keepRunning())
+            charging.completeLocationName("Location " + to_string(k++ % 10), 5);
+    });
+
+    suite.add("EVCharging/nearestChargingStations (k=5)", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        long k = 0;
+        while (state.keepRunning())
+            charging.nearestChargingStations(network.trips[k++ % network.trips.size()].first, 5);
+    });
+
+    // The update benchmarks come last: a road update drops the hierarchy the queries above use
+    suite.add("EVCharging/updateChargingStation", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        long k = 0;
+        while (state.keepRunning()) {
+            int index = network.trips[k++ % network.trips.size()].first;
+            Location row = charging.locationRow(index);
+            charging.updateChargingStation(index, !row.chargerInstalled, row.chargerInstalled ? -1 : 0.3);
+            charging.updateChargingStation(index, row.chargerInstalled, row.chargingPrice);
+        }
+    });
+
+    suite.add("EVCharging/updateRoadDistance", [](BenchmarkState& state) {
+        NetworkFixture& network = networkOfSize(state.range());
+        EVCharging& charging = fixtureEngine(network);
+        WeightedGraphType graph((int)network.size, network.weightsFileName.c_str(), EDGE_LIST);
+        long k = 0;
+        while (state.keepRunning()) {
+            int from = network.trips[k++ % network.trips.size()].second;
+            if (graph.edgeBegin(from) == graph.edgeEnd(from))
+                continue;
+            int to = graph.edgeTarget(graph.edgeBegin(from));
+            double weight = graph.getWeight(from, to);
+            charging.updateRoadDistance(from, to, weight * 3);
+            charging.updateRoadDistance(from, to, weight);
+        }
+    });
+}
+
+int main(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    vector<long> sizes = { 100, 10000, 1000000 };
+    if (!BenchmarkSuite::parseArguments(argc, argv, options, sizes))
+        return 1;
+
+    BenchmarkSuite suite;
+    addGraphBenchmarks(suite);
+    addChargingBenchmarks(suite);
+    return suite.run(sizes, options) ? 0 : 1;
+}
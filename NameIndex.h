@@ -0,0 +1,185 @@
+//
+//  NameIndex.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef NameIndex_h
+#define NameIndex_h
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+
+using namespace std;
+
+// Class definition for NameIndex, a lookup from location names to location indices.
+// Names are interned once, case-folded, into one character pool. Exact and case-insensitive
+// lookups go through a flat open-addressing hash table (linear probing, kept at most half
+// full), so resolving a name costs one hash and usually one comparison. Prefix lookups for
+// autocomplete binary search a list of the folded names in sorted order, which is sorted on
+// the first prefix lookup rather than in build: sorting is most of the build time, and
+// startup should not wait for autocomplete
+class NameIndex {
+private:
+    vector<string> names;          // Original names, by location index
+    string pool;                   // Case-folded names, back to back
+    vector<uint32_t> poolOffsets;  // Folded name i is pool[poolOffsets[i], poolOffsets[i + 1])
+    vector<int> slots;             // Hash table of location indices (-1 marks an empty slot)
+    vector<uint32_t> slotHashes;   // Full hash of the name in each slot, checked before comparing
+    mutable vector<int> sortedByName; // Location indices ordered by folded name (empty until the first prefix lookup)
+    mutable mutex sortMutex;          // Guards sortedByName
+
+    // Fold one character to lower case (ASCII only, independent of the locale)
+    static char foldChar(char c) {
+        return (c >= 'A' && c <= 'Z') ? (char)(c - 'A' + 'a') : c;
+    }
+
+    // Fold a name to lower case, the key used by the hash and the sorted list
+    static string fold(const string& name) {
+        string folded(name);
+        for (char& c : folded)
+            c = foldChar(c);
+        return folded;
+    }
+
+    // 32-bit FNV-1a hash of a name, folded on the fly so lookups need no copy
+    static uint32_t hashOf(const char* text, size_t length) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (unsigned char)foldChar(text[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // Sort the location indices by folded name, if that has not been done since build
+    void sortNames() const;
+
+    // Check whether the folded name of a location equals the name, ignoring case
+    bool foldedEquals(int index, const string& name) const {
+        size_t length = poolOffsets[index + 1] - poolOffsets[index];
+        if (length != name.size())
+            return false;
+        const char* folded = pool.data() + poolOffsets[index];
+        for (size_t i = 0; i < length; i++)
+            if (folded[i] != foldChar(name[i]))
+                return false;
+        return true;
+    }
+
+public:
+    // Build the index over the given names; names[i] belongs to location i
+    void build(vector<string> locationNames);
+
+    // Get the location with exactly this name, or failing that one whose name differs only
+    // in case (-1 if there is none)
+    int find(const string& name) const;
+
+    // Get up to limit locations whose name starts with the prefix, ignoring case, in name order
+    vector<int> findPrefix(const string& prefix, int limit) const;
+
+    // Get the number of names in the index
+    int size() const {
+        return (int)names.size();
+    }
+};
+
+
+// Function to build the index
+// The table has a power-of-two number of slots at least twice the number of names, so
+// probe sequences stay short
+void NameIndex::build(vector<string> locationNames) {
+    names = move(locationNames);
+    pool.clear();
+    poolOffsets.assign(1, 0);
+
+    for (const string& name : names) {
+        pool += fold(name);
+        poolOffsets.push_back((uint32_t)pool.size());
+    }
+
+    size_t capacity = 1;
+    while (capacity < names.size() * 2)
+        capacity *= 2;
+    slots.assign(capacity, -1);
+    slotHashes.assign(capacity, 0);
+
+    // Insert every name at the first free slot of its probe sequence
+    for (int i = 0; i < (int)names.size(); i++) {
+        uint32_t hash = hashOf(pool.data() + poolOffsets[i], poolOffsets[i + 1] - poolOffsets[i]);
+        size_t slot = hash & (capacity - 1);
+        while (slots[slot] != -1)
+            slot = (slot + 1) & (capacity - 1);
+        slots[slot] = i;
+        slotHashes[slot] = hash;
+    }
+
+    lock_guard<mutex> lock(sortMutex);
+    sortedByName.clear();
+}
+
+
+// Function to sort the location indices by folded name for prefix lookups
+void NameIndex::sortNames() const {
+    if (!sortedByName.empty() || names.empty())
+        return;
+
+    sortedByName.resize(names.size());
+    for (int i = 0; i < (int)names.size(); i++)
+        sortedByName[i] = i;
+    sort(sortedByName.begin(), sortedByName.end(), [&](int a, int b) {
+        return pool.compare(poolOffsets[a], poolOffsets[a + 1] - poolOffsets[a], pool, poolOffsets[b], poolOffsets[b + 1] - poolOffsets[b]) < 0;
+    });
+}
+
+
+// Function to find a location by name
+// Every name that folds to the same key sits on the same probe sequence, so one walk finds
+// both the exact match and the first case-insensitive one
+int NameIndex::find(const string& name) const {
+    if (slots.empty())
+        return -1;
+
+    uint32_t hash = hashOf(name.data(), name.size());
+    size_t mask = slots.size() - 1;
+    int caseInsensitive = -1;
+
+    for (size_t slot = hash & mask; slots[slot] != -1; slot = (slot + 1) & mask) {
+        int index = slots[slot];
+        if (slotHashes[slot] != hash || !foldedEquals(index, name))
+            continue;
+        if (names[index] == name)
+            return index;
+        if (caseInsensitive == -1)
+            caseInsensitive = index;
+    }
+    return caseInsensitive;
+}
+
+
+// Function to list the locations whose name starts with a prefix
+vector<int> NameIndex::findPrefix(const string& prefix, int limit) const {
+    vector<int> matches;
+    string folded = fold(prefix);
+    lock_guard<mutex> lock(sortMutex);
+    sortNames();
+
+    // The matches are the run of sorted names starting at the first name not below the prefix
+    vector<int>::const_iterator it = lower_bound(sortedByName.begin(), sortedByName.end(), folded, [&](int index, const string& key) {
+        return pool.compare(poolOffsets[index], poolOffsets[index + 1] - poolOffsets[index], key) < 0;
+    });
+
+    for (; it != sortedByName.end() && (int)matches.size() < limit; it++) {
+        size_t length = poolOffsets[*it + 1] - poolOffsets[*it];
+        if (length < folded.size() || pool.compare(poolOffsets[*it], folded.size(), folded) != 0)
+            break;
+        matches.push_back(*it);
+    }
+    return matches;
+}
+
+#endif /* NameIndex_h */
@@ -0,0 +1,213 @@
+//
+//  NetworkSnapshot.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef NetworkSnapshot_h
+#define NetworkSnapshot_h
+
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+#include "WeightedGraph.h"
+
+// On-disk layout of a network snapshot (every block starts 8-byte aligned):
+//   NetworkSnapshotHeader
+//   double edgeWeights[edgeCount]
+//   double chargingPrices[locationCount]
+//   double latitudes[locationCount]          (NaN where the locations file gives no coordinates)
+//   double longitudes[locationCount]
+//   int32_t edgeOffsets[vertexCount + 1]
+//   int32_t edgeTargets[edgeCount]
+//   uint32_t nameOffsets[locationCount + 1]  (name i is names[nameOffsets[i], nameOffsets[i + 1]))
+//   uint8_t chargerInstalled[locationCount]
+//   char names[namePoolSize]
+struct NetworkSnapshotHeader {
+    char magic[8];               // "EVSNAP2" followed by a zero byte
+    uint32_t vertexCount;        // Number of vertices in the graph
+    uint32_t locationCount;      // Number of locations
+    uint64_t edgeCount;          // Number of directed edges
+    uint64_t namePoolSize;       // Total length of all location names
+    uint64_t weightsChecksum;    // FNV-1a checksum of the weights file the snapshot was taken from
+    uint64_t locationsChecksum;  // FNV-1a checksum of the locations file the snapshot was taken from
+};
+
+// Class definition for NetworkSnapshot, a binary copy of the parsed road network and
+// locations. Loading it is a handful of block copies instead of parsing text, and the
+// checksums of the text files tell when it is out of date
+class NetworkSnapshot {
+private:
+    static constexpr const char* magicString = "EVSNAP2";
+    static const int blockCount = 9;
+
+    // Round a byte count up to the next multiple of 8
+    static size_t aligned(size_t bytes) {
+        return (bytes + 7) & ~(size_t)7;
+    }
+
+    // Size in bytes of every block, in file order
+    static void blockSizes(const NetworkSnapshotHeader& header, size_t sizes[blockCount]) {
+        sizes[0] = aligned(header.edgeCount * sizeof(double));
+        sizes[1] = aligned(header.locationCount * sizeof(double));
+        sizes[2] = aligned(header.locationCount * sizeof(double));
+        sizes[3] = aligned(header.locationCount * sizeof(double));
+        sizes[4] = aligned(((size_t)header.vertexCount + 1) * sizeof(int32_t));
+        sizes[5] = aligned(header.edgeCount * sizeof(int32_t));
+        sizes[6] = aligned(((size_t)header.locationCount + 1) * sizeof(uint32_t));
+        sizes[7] = aligned(header.locationCount);
+        sizes[8] = aligned(header.namePoolSize);
+    }
+
+public:
+    // Write the graph and the locations to fileName. Returns false if the file cannot be written
+    static bool write(const char* fileName, WeightedGraphType& graph, const vector<string>& names,
+                      const vector<bool>& chargerInstalled, const vector<double>& chargingPrices,
+                      const vector<double>& latitudes, const vector<double>& longitudes,
+                      uint64_t weightsChecksum, uint64_t locationsChecksum);
+
+    // Read a snapshot into the graph and the location arrays. Returns false, changing nothing,
+    // if the file is missing, damaged, or was taken from different text files (stale)
+    static bool read(const char* fileName, uint64_t weightsChecksum, uint64_t locationsChecksum,
+                     WeightedGraphType& graph, vector<string>& names, vector<bool>& chargerInstalled,
+                     vector<double>& chargingPrices, vector<double>& latitudes, vector<double>& longitudes);
+};
+
+
+// Function to write a snapshot
+// The file is written under a temporary name and renamed when complete
+bool NetworkSnapshot::write(const char* fileName, WeightedGraphType& graph, const vector<string>& names,
+                            const vector<bool>& chargerInstalled, const vector<double>& chargingPrices,
+                            const vector<double>& latitudes, const vector<double>& longitudes,
+                            uint64_t weightsChecksum, uint64_t locationsChecksum) {
+    string tempFileName = string(fileName) + ".tmp";
+
+    // Fill in the header
+    NetworkSnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    strcpy(header.magic, magicString);
+    header.vertexCount = graph.getNumberOfVertices();
+    header.locationCount = (uint32_t)names.size();
+    header.edgeCount = graph.getNumberOfEdges();
+    for (const string& name : names)
+        header.namePoolSize += name.size();
+    header.weightsChecksum = weightsChecksum;
+    header.locationsChecksum = locationsChecksum;
+
+    size_t sizes[blockCount];
+    blockSizes(header, sizes);
+    size_t total = sizeof(header);
+    for (size_t size : sizes)
+        total += size;
+
+    MappedFile output;
+    if (!output.create(tempFileName.c_str(), total)) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+
+    // Lay the blocks out one after another; the new file is zero-filled, so padding needs no writes
+    char* block[blockCount];
+    block[0] = output.data() + sizeof(header);
+    for (int b = 1; b < blockCount; b++)
+        block[b] = block[b - 1] + sizes[b - 1];
+
+    memcpy(output.data(), &header, sizeof(header));
+    memcpy(block[0], graph.getEdgeWeights().data(), header.edgeCount * sizeof(double));
+    memcpy(block[1], chargingPrices.data(), header.locationCount * sizeof(double));
+    memcpy(block[2], latitudes.data(), header.locationCount * sizeof(double));
+    memcpy(block[3], longitudes.data(), header.locationCount * sizeof(double));
+    memcpy(block[4], graph.getEdgeOffsets().data(), ((size_t)header.vertexCount + 1) * sizeof(int32_t));
+    memcpy(block[5], graph.getEdgeTargets().data(), header.edgeCount * sizeof(int32_t));
+
+    uint32_t* nameOffsets = (uint32_t*)block[6];
+    char* pool = block[8];
+    nameOffsets[0] = 0;
+    for (uint32_t i = 0; i < header.locationCount; i++) {
+        block[7][i] = chargerInstalled[i] ? 1 : 0;
+        memcpy(pool + nameOffsets[i], names[i].data(), names[i].size());
+        nameOffsets[i + 1] = nameOffsets[i] + (uint32_t)names[i].size();
+    }
+
+    bool ok = output.flush();
+    output.close();
+
+    // Replace the old snapshot in one step, so readers never see a half-written file
+    if (!ok || rename(tempFileName.c_str(), fileName) != 0) {
+        remove(tempFileName.c_str());
+        cout << "Cannot write network snapshot: " << fileName << endl;
+        return false;
+    }
+    return true;
+}
+
+
+// Function to read a snapshot and check it matches the current text files
+bool NetworkSnapshot::read(const char* fileName, uint64_t weightsChecksum, uint64_t locationsChecksum,
+                           WeightedGraphType& graph, vector<string>& names, vector<bool>& chargerInstalled,
+                           vector<double>& chargingPrices, vector<double>& latitudes, vector<double>& longitudes) {
+    MappedFile file;
+    if (!file.openReadOnly(fileName))
+        return false;
+
+    NetworkSnapshotHeader header;
+    if (file.length() < sizeof(header))
+        return false;
+    memcpy(&header, file.data(), sizeof(header));
+
+    // Reject snapshots of another format or of other text files
+    if (memcmp(header.magic, magicString, sizeof(header.magic)) != 0 || header.weightsChecksum != weightsChecksum ||
+        header.locationsChecksum != locationsChecksum || header.edgeCount > (uint64_t)INT32_MAX)
+        return false;
+
+    size_t sizes[blockCount];
+    blockSizes(header, sizes);
+    size_t total = sizeof(header);
+    for (size_t size : sizes)
+        total += size;
+    if (file.length() != total)
+        return false;
+
+    const char* block[blockCount];
+    block[0] = file.data() + sizeof(header);
+    for (int b = 1; b < blockCount; b++)
+        block[b] = block[b - 1] + sizes[b - 1];
+
+    const double* weights = (const double*)block[0];
+    const double* prices = (const double*)block[1];
+    const double* latitudeBlock = (const double*)block[2];
+    const double* longitudeBlock = (const double*)block[3];
+    const int32_t* offsets = (const int32_t*)block[4];
+    const int32_t* targets = (const int32_t*)block[5];
+    const uint32_t* nameOffsets = (const uint32_t*)block[6];
+    const uint8_t* chargers = (const uint8_t*)block[7];
+    const char* pool = block[8];
+
+    // Check every name lies inside the pool before anything is changed
+    for (uint32_t i = 0; i < header.locationCount; i++)
+        if (nameOffsets[i] > nameOffsets[i + 1] || nameOffsets[i + 1] > header.namePoolSize)
+            return false;
+
+    // Copy the graph blocks out of the mapping; setEdges checks they form a valid graph
+    if (!graph.setEdges(header.vertexCount, vector<int>(offsets, offsets + header.vertexCount + 1),
+                        vector<int>(targets, targets + header.edgeCount), vector<double>(weights, weights + header.edgeCount)))
+        return false;
+
+    // Then the locations
+    names.assign(header.locationCount, string());
+    chargerInstalled.assign(header.locationCount, false);
+    chargingPrices.assign(prices, prices + header.locationCount);
+    latitudes.assign(latitudeBlock, latitudeBlock + header.locationCount);
+    longitudes.assign(longitudeBlock, longitudeBlock + header.locationCount);
+    for (uint32_t i = 0; i < header.locationCount; i++) {
+        names[i].assign(pool + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]);
+        chargerInstalled[i] = chargers[i] != 0;
+    }
+    return true;
+}
+
+#endif /* NetworkSnapshot_h */
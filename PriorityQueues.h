@@ -0,0 +1,211 @@
+//
+//  PriorityQueues.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef PriorityQueues_h
+#define PriorityQueues_h
+
+#include <cstdint>
+#include <vector>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+// Min-priority queues of (key, vertex) entries with integer keys, for the searches over
+// fixed-point road distances (WeightedGraphType::shortestPathFixed). They all offer the same
+// members, so the search takes the queue type as a template parameter:
+//     reset(largestStep)  empty the queue for a new search; largestStep is the largest edge weight
+//     empty()             check whether any entry is left
+//     push(key, vertex)   add an entry
+//     pop(key)            remove an entry with the smallest key, returning its vertex and key
+// Like the heaps of the floating point searches they keep stale entries, which the search skips.
+// Dijkstra's algorithm only ever pushes keys no smaller than the last key popped, which the radix
+// heap and Dial's buckets rely on. Every queue keeps its buffers between searches
+
+// Binary heap over a vector, managed with push_heap/pop_heap: O(log n) per push and pop
+class BinaryHeapQueue {
+private:
+    vector<pair<uint64_t, int>> heap;
+
+public:
+    void reset(uint64_t) {
+        heap.clear();
+    }
+    bool empty() const {
+        return heap.empty();
+    }
+    void push(uint64_t key, int vertex) {
+        heap.push_back(make_pair(key, vertex));
+        push_heap(heap.begin(), heap.end(), greater<pair<uint64_t, int>>());
+    }
+    int pop(uint64_t& key) {
+        pop_heap(heap.begin(), heap.end(), greater<pair<uint64_t, int>>());
+        key = heap.back().first;
+        int vertex = heap.back().second;
+        heap.pop_back();
+        return vertex;
+    }
+};
+
+// Heap with four children per node: half as deep as the binary heap, so a push moves an entry
+// up fewer levels, and the four children of a node share a cache line when popping
+class QuaternaryHeapQueue {
+private:
+    vector<pair<uint64_t, int>> heap;
+
+public:
+    void reset(uint64_t) {
+        heap.clear();
+    }
+    bool empty() const {
+        return heap.empty();
+    }
+    void push(uint64_t key, int vertex) {
+        size_t k = heap.size();
+        heap.push_back(make_pair(key, vertex));
+        while (k > 0 && heap[(k - 1) / 4].first > key) {
+            heap[k] = heap[(k - 1) / 4];
+            k = (k - 1) / 4;
+        }
+        heap[k] = make_pair(key, vertex);
+    }
+    int pop(uint64_t& key);
+};
+
+// Radix heap (Ahuja, Mehlhorn, Orlin and Tarjan): an entry goes into the bucket of the highest
+// bit in which its key differs from the last key popped. Popping from an empty bucket 0 takes
+// the smallest key of the first non-empty bucket as the new last key and spreads that bucket
+// over the lower ones. An entry only ever moves down, at most once per bit of the key
+class RadixHeapQueue {
+private:
+    static const int bucketCount = 65; // Bucket 0 holds keys equal to last, bucket b keys whose highest different bit is b - 1
+    vector<pair<uint64_t, int>> buckets[bucketCount];
+    uint64_t last = 0;
+    size_t count = 0;
+
+    // Get the bucket of a key
+    int bucketOf(uint64_t key) const {
+        return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+    }
+
+public:
+    void reset(uint64_t) {
+        for (vector<pair<uint64_t, int>>& bucket : buckets)
+            bucket.clear();
+        last = 0;
+        count = 0;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    void push(uint64_t key, int vertex) {
+        buckets[bucketOf(key)].push_back(make_pair(key, vertex));
+        count++;
+    }
+    int pop(uint64_t& key);
+};
+
+// Dial's buckets: one bucket per key, in a ring of largestStep + 1 buckets. Every key in the
+// queue lies between the last key popped and that plus the largest edge weight, so no two of
+// them share a bucket. Popping walks the ring forward to the next non-empty bucket, so a whole
+// search costs O(E + the longest distance). Best when the weights are small integers
+class DialQueue {
+private:
+    vector<vector<int>> buckets;
+    size_t position = 0; // Bucket of the last key popped
+    uint64_t current = 0; // Last key popped
+    size_t count = 0;
+
+public:
+    void reset(uint64_t largestStep) {
+        if (buckets.size() != largestStep + 1)
+            buckets.resize(largestStep + 1);
+        for (vector<int>& bucket : buckets)
+            bucket.clear();
+        position = 0;
+        current = 0;
+        count = 0;
+    }
+    bool empty() const {
+        return count == 0;
+    }
+    void push(uint64_t key, int vertex) {
+        size_t k = position + (size_t)(key - current);
+        if (k >= buckets.size())
+            k -= buckets.size();
+        buckets[k].push_back(vertex);
+        count++;
+    }
+    int pop(uint64_t& key) {
+        while (buckets[position].empty()) {
+            if (++position == buckets.size())
+                position = 0;
+            current++;
+        }
+        key = current;
+        int vertex = buckets[position].back();
+        buckets[position].pop_back();
+        count--;
+        return vertex;
+    }
+};
+
+
+// Function to remove the smallest entry of the 4-ary heap
+// The last entry takes the place of the root and moves down past its smallest child
+int QuaternaryHeapQueue::pop(uint64_t& key) {
+    key = heap[0].first;
+    int vertex = heap[0].second;
+    pair<uint64_t, int> moving = heap.back();
+    heap.pop_back();
+
+    size_t n = heap.size(), k = 0;
+    while (true) {
+        size_t first = 4 * k + 1;
+        if (first >= n)
+            break;
+        size_t smallest = first;
+        for (size_t c = first + 1; c < min(first + 4, n); c++)
+            if (heap[c].first < heap[smallest].first)
+                smallest = c;
+        if (heap[smallest].first >= moving.first)
+            break;
+        heap[k] = heap[smallest];
+        k = smallest;
+    }
+    if (n > 0)
+        heap[k] = moving;
+    return vertex;
+}
+
+
+// Function to remove an entry with the smallest key from the radix heap
+int RadixHeapQueue::pop(uint64_t& key) {
+    if (buckets[0].empty()) {
+        int b = 1;
+        while (buckets[b].empty())
+            b++;
+
+        // The smallest key of the bucket becomes last; every other entry of it differs from
+        // the new last in a lower bit than before, so it lands in a lower bucket
+        uint64_t smallest = buckets[b][0].first;
+        for (const pair<uint64_t, int>& entry : buckets[b])
+            smallest = min(smallest, entry.first);
+        last = smallest;
+        for (const pair<uint64_t, int>& entry : buckets[b])
+            buckets[bucketOf(entry.first)].push_back(entry);
+        buckets[b].clear();
+    }
+
+    key = last;
+    int vertex = buckets[0].back().second;
+    buckets[0].pop_back();
+    count--;
+    return vertex;
+}
+
+#endif /* PriorityQueues_h */
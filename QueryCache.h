@@ -0,0 +1,152 @@
+//
+//  QueryCache.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef QueryCache_h
+#define QueryCache_h
+
+#include <cstdint>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+// Counters of a QueryCache, read with QueryCache::stats
+struct QueryCacheStats {
+    uint64_t hits = 0;          // Lookups answered from the cache
+    uint64_t misses = 0;        // Lookups that had to be computed (stale entries included)
+    uint64_t evictions = 0;     // Entries dropped to make room
+    uint64_t invalidations = 0; // Entries dropped because the data changed after they were stored
+    uint64_t entries = 0;       // Entries held now
+    uint64_t bytes = 0;         // Approximate memory held by the entries
+
+    double hitRate() const {
+        return hits + misses == 0 ? 0 : (double)hits / (hits + misses);
+    }
+};
+
+// Class definition for QueryCache, a bounded least-recently-used cache of answers keyed by
+// (task, origin, destination, kWh, battery capacity). Every entry carries the data version it
+// was computed under; a lookup under a newer version treats it as a miss and drops it, so a
+// change of weights or prices invalidates everything at once without walking the cache.
+// The cache is split into shards by key hash, each with its own lock and LRU list, so threads
+// looking up different queries rarely wait for each other
+template <class Key, class Value, class Hash>
+class QueryCache {
+private:
+    struct Entry {
+        Key key;
+        Value value;
+        uint64_t version; // Data version the value was computed under
+        size_t bytes;     // Approximate size, as given to insert
+    };
+
+    struct Shard {
+        mutex entriesMutex;
+        list<Entry> entries; // Most recently used first
+        unordered_map<Key, typename list<Entry>::iterator, Hash> index;
+        size_t bytes = 0;
+    };
+
+    static const int shardCount = 16;
+    Shard shards[shardCount];
+    size_t shardCapacity; // Entries per shard before the least recently used one is evicted
+
+    atomic<uint64_t> hits;
+    atomic<uint64_t> misses;
+    atomic<uint64_t> evictions;
+    atomic<uint64_t> invalidations;
+
+    Shard& shardOf(const Key& key) {
+        return shards[(Hash()(key) >> 7) % shardCount];
+    }
+
+    // Drop one entry of a shard (its lock must be held)
+    void erase(Shard& shard, typename list<Entry>::iterator it) {
+        shard.bytes -= it->bytes;
+        shard.index.erase(it->key);
+        shard.entries.erase(it);
+    }
+
+public:
+    // Hold about capacity entries in total (at least one per shard)
+    QueryCache(size_t capacity = 4096)
+        : shardCapacity(max((size_t)1, capacity / shardCount)), hits(0), misses(0), evictions(0), invalidations(0) {}
+
+    // Look up a key computed under the given version. Returns false on a miss
+    bool find(const Key& key, uint64_t version, Value& value) {
+        Shard& shard = shardOf(key);
+        lock_guard<mutex> lock(shard.entriesMutex);
+
+        typename unordered_map<Key, typename list<Entry>::iterator, Hash>::iterator found = shard.index.find(key);
+        if (found == shard.index.end()) {
+            misses++;
+            return false;
+        }
+        if (found->second->version != version) {
+            erase(shard, found->second);
+            invalidations++;
+            misses++;
+            return false;
+        }
+
+        // Move the entry to the front of the LRU list
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        value = found->second->value;
+        hits++;
+        return true;
+    }
+
+    // Store a value computed under the given version, evicting the least recently used entry
+    // of the shard if it is full. bytes is the approximate memory the value holds
+    void insert(const Key& key, const Value& value, uint64_t version, size_t bytes) {
+        Shard& shard = shardOf(key);
+        lock_guard<mutex> lock(shard.entriesMutex);
+
+        typename unordered_map<Key, typename list<Entry>::iterator, Hash>::iterator found = shard.index.find(key);
+        if (found != shard.index.end())
+            erase(shard, found->second);
+
+        while (shard.entries.size() >= shardCapacity) {
+            erase(shard, prev(shard.entries.end()));
+            evictions++;
+        }
+
+        bytes += sizeof(Entry) + 4 * sizeof(void*); // The list node and the index node
+        shard.entries.push_front({ key, value, version, bytes });
+        shard.index[key] = shard.entries.begin();
+        shard.bytes += bytes;
+    }
+
+    // Drop every entry (the counters are kept)
+    void clear() {
+        for (Shard& shard : shards) {
+            lock_guard<mutex> lock(shard.entriesMutex);
+            shard.entries.clear();
+            shard.index.clear();
+            shard.bytes = 0;
+        }
+    }
+
+    // Get the counters and the current size
+    QueryCacheStats stats() {
+        QueryCacheStats result;
+        result.hits = hits;
+        result.misses = misses;
+        result.evictions = evictions;
+        result.invalidations = invalidations;
+        for (Shard& shard : shards) {
+            lock_guard<mutex> lock(shard.entriesMutex);
+            result.entries += shard.entries.size();
+            result.bytes += shard.bytes;
+        }
+        return result;
+    }
+};
+
+#endif /* QueryCache_h */
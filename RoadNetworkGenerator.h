@@ -0,0 +1,217 @@
+//
+//  RoadNetworkGenerator.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef RoadNetworkGenerator_h
+#define RoadNetworkGenerator_h
+
+#include <cstdio>
+#include <cmath>
+#include <charconv>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+#include "WeightedGraph.h"
+
+using namespace std;
+
+// Shape of a synthetic road network
+struct RoadNetworkOptions {
+    int locations = 100;          // Number of locations (vertices)
+    double degree = 3;            // Average number of roads per location, between 2 and 6
+    double chargerDensity = 0.3;  // Fraction of locations with a charger
+    double freeShare = 0.2;       // Fraction of the chargers that are free
+    double spacing = 5;           // Distance between neighbouring locations in km
+    unsigned seed = 1;
+};
+
+// Class definition for RoadNetworkGenerator, which writes random planar road networks in the
+// Weights.txt and Locations.txt formats, for benchmarks at any size.
+// Locations sit on a jittered square grid. The candidate roads are the grid edges plus one
+// diagonal per grid cell, which triangulates the grid, so no two roads cross. A random
+// spanning tree of the candidates keeps the network connected, and further candidates are
+// added in random order until the average degree is reached. A road is as long as the
+// straight line between its ends times a small detour factor, rounded to 0.1 km like the sample
+class RoadNetworkGenerator {
+private:
+    // Position of the top left corner of the grid, in degrees
+    static constexpr double originLatitude = -33.8688;
+    static constexpr double originLongitude = 151.2093;
+    static constexpr double kilometresPerDegree = 111.195;
+
+    // Union-find root with path halving
+    static int root(vector<int>& parent, int v) {
+        while (parent[v] != v) {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+
+    // Append a number to a text buffer
+    template <class Number>
+    static void append(string& out, Number value) {
+        char text[32];
+        out.append(text, to_chars(text, text + sizeof(text), value).ptr);
+    }
+
+public:
+    // Generate a network and write it to weightsFileName (in the given format) and
+    // locationsFileName. Returns false if a file cannot be written
+    static bool write(const RoadNetworkOptions& options, const char* weightsFileName, const char* locationsFileName,
+                      GraphFileFormat format = EDGE_LIST);
+};
+
+
+// Function to generate and write a network
+bool RoadNetworkGenerator::write(const RoadNetworkOptions& options, const char* weightsFileName, const char* locationsFileName,
+                                 GraphFileFormat format) {
+    int n = max(1, options.locations);
+    int columns = (int)ceil(sqrt((double)n));
+    mt19937 generator(options.seed);
+    uniform_real_distribution<double> unit(0.0, 1.0);
+
+    // Jittered grid positions
+    vector<double> x(n), y(n);
+    for (int v = 0; v < n; v++) {
+        x[v] = (v % columns + 0.6 * (unit(generator) - 0.5)) * options.spacing;
+        y[v] = (v / columns + 0.6 * (unit(generator) - 0.5)) * options.spacing;
+    }
+
+    // Candidate roads: right and down neighbours, and one diagonal of each cell
+    vector<pair<int, int>> candidates;
+    candidates.reserve((size_t)n * 3);
+    for (int v = 0; v < n; v++) {
+        int column = v % columns;
+        bool right = column + 1 < columns && v + 1 < n;
+        bool down = v + columns < n;
+        if (right)
+            candidates.push_back({v, v + 1});
+        if (down)
+            candidates.push_back({v, v + columns});
+        if (right && down && v + columns + 1 < n) {
+            if (generator() % 2 == 0)
+                candidates.push_back({v, v + columns + 1});
+            else
+                candidates.push_back({v + 1, v + columns});
+        }
+    }
+    shuffle(candidates.begin(), candidates.end(), generator);
+
+    // A spanning tree first (Kruskal over the shuffled candidates), then extra roads up to the degree
+    vector<int> parent(n);
+    for (int v = 0; v < n; v++)
+        parent[v] = v;
+    vector<pair<int, int>> roads, extra;
+    for (const pair<int, int>& road : candidates) {
+        int a = root(parent, road.first), b = root(parent, road.second);
+        if (a != b) {
+            parent[a] = b;
+            roads.push_back(road);
+        } else {
+            extra.push_back(road);
+        }
+    }
+    size_t target = (size_t)(min(6.0, max(2.0, options.degree)) * n / 2);
+    for (size_t k = 0; k < extra.size() && roads.size() < target; k++)
+        roads.push_back(extra[k]);
+
+    vector<double> lengths(roads.size());
+    for (size_t k = 0; k < roads.size(); k++) {
+        double dx = x[roads[k].first] - x[roads[k].second], dy = y[roads[k].first] - y[roads[k].second];
+        double detour = 1.0 + 0.3 * unit(generator);
+        lengths[k] = max(0.1, round(sqrt(dx * dx + dy * dy) * detour * 10) / 10);
+    }
+
+    // Write the weights
+    FILE* weights = fopen(weightsFileName, "w");
+    if (weights == nullptr) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+    string out;
+    if (format == EDGE_LIST) {
+        out += "# ";
+        append(out, n);
+        out += " locations, ";
+        append(out, roads.size());
+        out += " roads\n";
+        for (size_t k = 0; k < roads.size(); k++) {
+            for (int direction = 0; direction < 2; direction++) {
+                append(out, direction == 0 ? roads[k].first : roads[k].second);
+                out += ' ';
+                append(out, direction == 0 ? roads[k].second : roads[k].first);
+                out += ' ';
+                append(out, lengths[k]);
+                out += '\n';
+            }
+            if (out.size() >= (1 << 20)) {
+                fwrite(out.data(), 1, out.size(), weights);
+                out.clear();
+            }
+        }
+    } else {
+        // The matrix is written one row at a time from each location's road list
+        vector<vector<pair<int, double>>> adjacent(n);
+        for (size_t k = 0; k < roads.size(); k++) {
+            adjacent[roads[k].first].push_back({roads[k].second, lengths[k]});
+            adjacent[roads[k].second].push_back({roads[k].first, lengths[k]});
+        }
+        vector<double> row(n, 0);
+        for (int v = 0; v < n; v++) {
+            for (const pair<int, double>& road : adjacent[v])
+                row[road.first] = road.second;
+            for (int j = 0; j < n; j++) {
+                append(out, row[j]);
+                out += (j + 1 < n ? '\t' : '\n');
+            }
+            for (const pair<int, double>& road : adjacent[v])
+                row[road.first] = 0;
+            if (out.size() >= (1 << 20)) {
+                fwrite(out.data(), 1, out.size(), weights);
+                out.clear();
+            }
+        }
+    }
+    fwrite(out.data(), 1, out.size(), weights);
+    bool ok = fclose(weights) == 0;
+
+    // Write the locations: name, charger flag, price in dollars per kWh (-1 without a charger),
+    // and the position in degrees, with the grid laid out around Sydney (1 degree of latitude
+    // is 111.195 km, a degree of longitude that times the cosine of the latitude)
+    FILE* locations = fopen(locationsFileName, "w");
+    if (locations == nullptr) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
+    out.clear();
+    for (int v = 0; v < n; v++) {
+        bool charger = unit(generator) < options.chargerDensity;
+        double price = -1;
+        if (charger)
+            price = unit(generator) < options.freeShare ? 0 : (20 + generator() % 41) / 100.0;
+
+        out += "Location ";
+        append(out, v);
+        out += charger ? ",1," : ",0,";
+        append(out, price);
+        out += ',';
+        append(out, round((originLatitude - y[v] / kilometresPerDegree) * 1e6) / 1e6);
+        out += ',';
+        append(out, round((originLongitude + x[v] / (kilometresPerDegree * cos(originLatitude * acos(-1.0) / 180))) * 1e6) / 1e6);
+        out += '\n';
+        if (out.size() >= (1 << 20)) {
+            fwrite(out.data(), 1, out.size(), locations);
+            out.clear();
+        }
+    }
+    fwrite(out.data(), 1, out.size(), locations);
+    return fclose(locations) == 0 && ok;
+}
+
+#endif /* RoadNetworkGenerator_h */
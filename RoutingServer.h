@@ -0,0 +1,673 @@
+//
+//  RoutingServer.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef RoutingServer_h
+#define RoutingServer_h
+
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <cfloat>
+#include <cmath>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "EVCharging.h"
+#include "BatchMode.h"
+
+using namespace std;
+
+// Class definition for LatencyHistogram, request latencies counted in power-of-two buckets of
+// microseconds: bucket 0 holds [0, 2) us and bucket b holds [2^b, 2^(b + 1)) us. The counters
+// are atomic, so every worker records into the same histogram without a lock
+class LatencyHistogram {
+private:
+    static const int bucketCount = 32;
+    atomic<uint64_t> buckets[bucketCount];
+    atomic<uint64_t> count;
+    atomic<uint64_t> maximum;
+
+public:
+    LatencyHistogram() : count(0), maximum(0) {
+        for (atomic<uint64_t>& bucket : buckets)
+            bucket = 0;
+    }
+
+    // Count one request that took the given number of microseconds
+    void record(uint64_t micros) {
+        int bucket = 0;
+        while (bucket < bucketCount - 1 && (micros >> (bucket + 1)) != 0)
+            bucket++;
+        buckets[bucket]++;
+        count++;
+
+        uint64_t seen = maximum;
+        while (micros > seen && !maximum.compare_exchange_weak(seen, micros)) {}
+    }
+
+    uint64_t total() const {
+        return count;
+    }
+    uint64_t largest() const {
+        return maximum;
+    }
+
+    // Get an upper bound on the given fraction (0 to 1) of the latencies: the top of the
+    // bucket holding that rank
+    uint64_t percentile(double fraction) const {
+        uint64_t rank = (uint64_t)(fraction * count + 0.5);
+        uint64_t seen = 0;
+        for (int b = 0; b < bucketCount; b++) {
+            seen += buckets[b];
+            if (seen >= rank && seen > 0)
+                return min(((uint64_t)2 << b) - 1, (uint64_t)maximum);
+        }
+        return maximum;
+    }
+};
+
+// Class definition for RoutingServer, a local query server over a Unix socket or a TCP port
+// bound to 127.0.0.1. It speaks the batch mode's line protocol: each request line is a query
+// as in BatchRunner and gets one reply line in the same format, and a client may send many
+// requests without waiting (pipelining); replies always come back in request order. Three
+// commands are understood as well: STATS replies with the latency histogram and the answer
+// cache counters of the current engine, RELOAD re-reads the input files (dropping any updates),
+// and UPDATE changes the current engine while it serves:
+//   UPDATE <TAB> ROAD <TAB> from <TAB> to <TAB> km        (one direction; km "closed" closes the road)
+//   UPDATE <TAB> CHARGER <TAB> location <TAB> 0 or 1 <TAB> price
+// An update waits until every request before it has been answered, and every request after it sees it.
+// One event loop thread polls every socket without blocking and cuts the input into lines;
+// a pool of workers answers them. All workers share one read-only engine through a
+// shared_ptr, so a reload builds the new engine in the background and swaps the pointer:
+// requests already taken keep the engine they started on, and none are dropped
+class RoutingServer {
+private:
+    // A client connection, owned by the event loop thread
+    struct Connection {
+        int fd;
+        string input;               // Bytes received but not yet cut into lines
+        string output;              // Replies ready to send, in request order
+        long nextSequence = 0;      // Sequence number given to the next request
+        long nextReply = 0;         // Sequence number of the next reply to send
+        map<long, string> finished; // Replies that finished before an earlier request
+        bool closing = false;       // The client has stopped sending (or misbehaved)
+    };
+
+    // A request handed to the workers
+    struct Job {
+        uint64_t connection;                   // Id of the connection it came from
+        long sequence;                         // Its position among that connection's requests
+        string line;                           // The request line
+        shared_ptr<EVCharging> engine;         // Engine current when the request arrived
+        chrono::steady_clock::time_point arrival;
+    };
+
+    // A finished reply on its way back to the event loop
+    struct Reply {
+        uint64_t connection;
+        long sequence;
+        string text;
+    };
+
+    string address;       // "unix:<path>" or "tcp:<port>"
+    BatchFormat format;
+    int threadCount;
+
+    int listener;         // Listening socket (-1 when closed)
+    int wakePipe[2];      // Written to wake the event loop: by workers, reloads and signals
+    string socketPath;    // Path of the Unix socket, removed on shutdown
+
+    map<uint64_t, Connection> connections;
+    uint64_t nextConnection;
+
+    shared_ptr<EVCharging> engine; // Engine given to new requests
+    mutex engineMutex;             // Guards engine
+    thread reloader;               // Builds the next engine during a reload
+    atomic<bool> reloading;
+    atomic<long> reloads;
+
+    BoundedQueue<Job> jobs;        // Requests waiting for a worker
+    vector<thread> workers;
+    vector<Reply> replies;         // Replies waiting for the event loop
+    mutex repliesMutex;            // Guards replies and jobsInFlight
+    long jobsInFlight;             // Requests handed to the workers whose replies are not back yet
+    condition_variable jobsDone;   // Signalled when jobsInFlight drops to zero
+
+    LatencyHistogram latency;
+
+    static const size_t readChunk = 1 << 16;     // Bytes read from a socket at a time
+    static const size_t maxLineLength = 1 << 16; // Longer lines close the connection
+    static const long maxInFlight = 1024;        // Requests per connection before reading pauses
+
+    // Set by the signal handlers and checked by the event loop
+    static volatile sig_atomic_t stopRequested;
+    static volatile sig_atomic_t reloadRequested;
+    static int signalWakeFd;
+
+    static void handleStop(int) {
+        stopRequested = 1;
+        if (signalWakeFd >= 0)
+            (void)!write(signalWakeFd, "s", 1);
+    }
+    static void handleReload(int) {
+        reloadRequested = 1;
+        if (signalWakeFd >= 0)
+            (void)!write(signalWakeFd, "r", 1);
+    }
+
+    // Wake the event loop from another thread
+    void wake() {
+        (void)!write(wakePipe[1], "w", 1);
+    }
+
+    // Open the listening socket. Returns false (with a message) if the address is invalid or taken
+    bool listenOn();
+    // Accept every pending connection
+    void acceptConnections();
+    // Read what a connection has sent and queue its complete lines
+    void readConnection(uint64_t id, Connection& connection);
+    // Send as much of a connection's output as the socket takes
+    void writeConnection(Connection& connection);
+    // Queue one request line, or answer it here if it is a command
+    void handleLine(uint64_t id, Connection& connection, string_view line);
+    // Move replies that are next in order into the output of their connection
+    void releaseReplies(Connection& connection);
+    // Collect the replies finished by the workers
+    void collectReplies();
+    // Start building a new engine from the input files, unless a reload is already running
+    void startReload();
+    // Apply the fields of an UPDATE command to an engine. Returns false if they are not valid
+    bool applyUpdate(EVCharging& current, const BatchRunner& protocol, string_view fields);
+    // Answer requests until the job queue is closed
+    void workerLoop();
+
+    // Get the engine for a new request
+    shared_ptr<EVCharging> currentEngine() {
+        lock_guard<mutex> lock(engineMutex);
+        return engine;
+    }
+
+public:
+    // The server answers with the given engine until a reload replaces it.
+    // threads is the number of workers (0 = one per hardware thread)
+    RoutingServer(shared_ptr<EVCharging> engine, const string& address, BatchFormat format = BATCH_TSV, int threads = 0);
+    ~RoutingServer();
+
+    // Serve until SIGINT or SIGTERM (SIGHUP reloads, like the RELOAD command). Requests already
+    // received are answered before it returns. Returns false if the server could not start
+    bool run();
+};
+
+volatile sig_atomic_t RoutingServer::stopRequested = 0;
+volatile sig_atomic_t RoutingServer::reloadRequested = 0;
+int RoutingServer::signalWakeFd = -1;
+
+
+// Constructor
+RoutingServer::RoutingServer(shared_ptr<EVCharging> engine, const string& address, BatchFormat format, int threads)
+    : address(address), format(format), threadCount(threads), listener(-1), nextConnection(0), engine(engine),
+      reloading(false), reloads(0), jobs(4096), jobsInFlight(0) {
+    wakePipe[0] = wakePipe[1] = -1;
+    if (threadCount <= 0)
+        threadCount = max(1, (int)thread::hardware_concurrency());
+}
+
+// Destructor
+RoutingServer::~RoutingServer() {
+    if (reloader.joinable())
+        reloader.join();
+    if (listener >= 0)
+        close(listener);
+    for (map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end(); it++)
+        close(it->second.fd);
+    if (wakePipe[0] >= 0) {
+        close(wakePipe[0]);
+        close(wakePipe[1]);
+    }
+    if (!socketPath.empty())
+        unlink(socketPath.c_str());
+}
+
+
+// Function to open the listening socket
+// TCP is only ever bound to the loopback interface; a stale Unix socket file is replaced
+bool RoutingServer::listenOn() {
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un local;
+        memset(&local, 0, sizeof(local));
+        local.sun_family = AF_UNIX;
+        socketPath = address.substr(5);
+        if (socketPath.empty() || socketPath.size() >= sizeof(local.sun_path)) {
+            cout << "Invalid socket path: " << socketPath << endl;
+            socketPath.clear();
+            return false;
+        }
+        strcpy(local.sun_path, socketPath.c_str());
+        unlink(socketPath.c_str());
+
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener < 0 || ::bind(listener, (sockaddr*)&local, sizeof(local)) != 0) {
+            cout << "Cannot listen on " << address << ": " << strerror(errno) << endl;
+            socketPath.clear();
+            return false;
+        }
+    } else {
+        string port = address.compare(0, 4, "tcp:") == 0 ? address.substr(4) : address;
+        int number = 0;
+        const char* end = port.data() + port.size();
+        if (port.empty() || from_chars(port.data(), end, number).ptr != end || number < 0 || number > 65535) {
+            cout << "Invalid address: " << address << " (use unix:<path> or tcp:<port>)" << endl;
+            return false;
+        }
+
+        sockaddr_in local;
+        memset(&local, 0, sizeof(local));
+        local.sin_family = AF_INET;
+        local.sin_port = htons((uint16_t)number);
+        local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        int reuse = 1;
+        if (listener >= 0)
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (listener < 0 || ::bind(listener, (sockaddr*)&local, sizeof(local)) != 0) {
+            cout << "Cannot listen on " << address << ": " << strerror(errno) << endl;
+            return false;
+        }
+    }
+
+    if (::listen(listener, 128) != 0) {
+        cout << "Cannot listen on " << address << ": " << strerror(errno) << endl;
+        return false;
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+
+// Function to accept new clients
+void RoutingServer::acceptConnections() {
+    while (true) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0)
+            return;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+        Connection& connection = connections[nextConnection++];
+        connection.fd = fd;
+    }
+}
+
+
+// Function to read from a client
+// Reading pauses (the socket is not polled) while the client has too many requests in flight,
+// so a client that never reads its replies cannot make the server buffer without limit
+void RoutingServer::readConnection(uint64_t id, Connection& connection) {
+    char buffer[readChunk];
+    ssize_t length = read(connection.fd, buffer, sizeof(buffer));
+    if (length < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            connection.closing = true;
+        return;
+    }
+    if (length == 0) {
+        // The client finished sending; a last line without a line break still counts
+        if (!connection.input.empty())
+            handleLine(id, connection, connection.input);
+        connection.input.clear();
+        connection.closing = true;
+        return;
+    }
+
+    connection.input.append(buffer, length);
+    size_t start = 0;
+    for (size_t newline; (newline = connection.input.find('\n', start)) != string::npos; start = newline + 1)
+        handleLine(id, connection, string_view(connection.input).substr(start, newline - start));
+    connection.input.erase(0, start);
+
+    if (connection.input.size() > maxLineLength) {
+        connection.input.clear();
+        connection.closing = true;
+    }
+}
+
+
+// Function to queue a request line
+void RoutingServer::handleLine(uint64_t id, Connection& connection, string_view line) {
+    long sequence = connection.nextSequence++;
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    // Commands are answered right away, but still wait their turn behind earlier requests.
+    // An update first lets the workers finish every request queued before it, and is applied
+    // before any later request is queued
+    if (line.substr(0, 6) == "UPDATE") {
+        {
+            unique_lock<mutex> lock(repliesMutex);
+            jobsDone.wait(lock, [&]() { return jobsInFlight == 0; });
+        }
+        shared_ptr<EVCharging> current = currentEngine();
+        BatchRunner protocol(*current, format);
+        string text;
+        bool applied = applyUpdate(*current, protocol, line.substr(6));
+        protocol.formatRecord("update", { { "applied", applied ? 1.0 : 0.0 } }, text);
+        connection.finished[sequence] = move(text);
+        releaseReplies(connection);
+        return;
+    }
+    if (line == "STATS" || line == "RELOAD") {
+        shared_ptr<EVCharging> current = currentEngine();
+        BatchRunner protocol(*current, format);
+        string text;
+        if (line == "RELOAD") {
+            startReload();
+            protocol.formatRecord("reload", { { "started", 1 }, { "reloads", (double)reloads } }, text);
+        } else {
+            QueryCacheStats cache = current->answerCacheStats();
+            protocol.formatRecord("stats", { { "requests", (double)latency.total() },
+                                             { "p50_us", (double)latency.percentile(0.5) },
+                                             { "p90_us", (double)latency.percentile(0.9) },
+                                             { "p99_us", (double)latency.percentile(0.99) },
+                                             { "max_us", (double)latency.largest() },
+                                             { "connections", (double)connections.size() },
+                                             { "reloads", (double)reloads },
+                                             { "locations", (double)current->getNumberOfLocations() },
+                                             { "rebuilding_index", current->rebuildingIndex() ? 1.0 : 0.0 },
+                                             { "cache_hits", (double)cache.hits },
+                                             { "cache_misses", (double)cache.misses },
+                                             { "cache_hit_rate", cache.hitRate() },
+                                             { "cache_evictions", (double)cache.evictions },
+                                             { "cache_invalidations", (double)cache.invalidations },
+                                             { "cache_entries", (double)cache.entries },
+                                             { "cache_bytes", (double)cache.bytes } }, text);
+        }
+        connection.finished[sequence] = move(text);
+        releaseReplies(connection);
+        return;
+    }
+
+    Job job;
+    job.connection = id;
+    job.sequence = sequence;
+    job.line = string(line);
+    job.engine = currentEngine();
+    job.arrival = chrono::steady_clock::now();
+    {
+        lock_guard<mutex> lock(repliesMutex);
+        jobsInFlight++;
+    }
+    jobs.push(move(job));
+}
+
+
+// Function to move the replies that are next in order to the output
+void RoutingServer::releaseReplies(Connection& connection) {
+    map<long, string>::iterator it;
+    while ((it = connection.finished.find(connection.nextReply)) != connection.finished.end()) {
+        connection.output += it->second;
+        connection.finished.erase(it);
+        connection.nextReply++;
+    }
+}
+
+
+// Function to write to a client
+void RoutingServer::writeConnection(Connection& connection) {
+    while (!connection.output.empty()) {
+        ssize_t length = send(connection.fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (length < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                connection.output.clear();
+                connection.closing = true;
+            }
+            return;
+        }
+        connection.output.erase(0, length);
+    }
+}
+
+
+// Function to collect finished replies
+// Replies for connections that have gone away are dropped
+void RoutingServer::collectReplies() {
+    vector<Reply> ready;
+    {
+        lock_guard<mutex> lock(repliesMutex);
+        ready.swap(replies);
+    }
+
+    for (Reply& reply : ready) {
+        map<uint64_t, Connection>::iterator it = connections.find(reply.connection);
+        if (it == connections.end())
+            continue;
+        it->second.finished[reply.sequence] = move(reply.text);
+        releaseReplies(it->second);
+    }
+    for (map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end(); it++)
+        writeConnection(it->second);
+}
+
+
+// Function to reload the input files
+// The new engine is built on its own thread while the old one keeps answering; a new engine
+// without any locations means the files could not be read, and the old one is kept
+void RoutingServer::startReload() {
+    if (reloading.exchange(true))
+        return;
+    if (reloader.joinable())
+        reloader.join();
+
+    reloader = thread([this]() {
+        shared_ptr<EVCharging> fresh = make_shared<EVCharging>();
+        if (fresh->getNumberOfLocations() > 0) {
+            lock_guard<mutex> lock(engineMutex);
+            engine = fresh;
+            reloads++;
+        } else {
+            cout << "Reload failed, still serving the previous network." << endl;
+        }
+        reloading = false;
+    });
+}
+
+
+// Function to apply an UPDATE command
+// The fields after UPDATE are split like a query line, on tabs or commas
+bool RoutingServer::applyUpdate(EVCharging& current, const BatchRunner& protocol, string_view fields) {
+    if (fields.empty() || (fields[0] != '\t' && fields[0] != ','))
+        return false;
+    fields.remove_prefix(1);
+
+    string_view field[5];
+    int fieldCount = 0;
+    while (fieldCount < 5) {
+        size_t separator = fields.find_first_of("\t,");
+        field[fieldCount++] = fields.substr(0, separator);
+        if (separator == string_view::npos)
+            break;
+        fields.remove_prefix(separator + 1);
+    }
+    if (fieldCount != 4)
+        return false;
+
+    // Parse a whole field as a finite number
+    auto number = [](string_view text, double& value) {
+        const char* end = text.data() + text.size();
+        return !text.empty() && from_chars(text.data(), end, value).ptr == end && isfinite(value);
+    };
+
+    if (field[0] == "ROAD") {
+        int from = protocol.parseLocation(field[1]);
+        int to = protocol.parseLocation(field[2]);
+        double distance = DBL_MAX;
+        if (from == -1 || to == -1 || (field[3] != "closed" && !number(field[3], distance)))
+            return false;
+        return current.updateRoadDistance(from, to, distance);
+    }
+    if (field[0] == "CHARGER") {
+        int location = protocol.parseLocation(field[1]);
+        double price;
+        if (location == -1 || (field[2] != "0" && field[2] != "1") || !number(field[3], price))
+            return false;
+        return current.updateChargingStation(location, field[2] == "1", price);
+    }
+    return false;
+}
+
+
+// Function run by each worker
+void RoutingServer::workerLoop() {
+    Job job;
+    while (jobs.pop(job)) {
+        BatchRunner protocol(*job.engine, format);
+        BatchItem item;
+        item.number = job.sequence + 1;
+
+        // Blank and comment lines get an empty reply, so the sequence has no gaps
+        string text;
+        if (protocol.parseLine(job.line, item)) {
+            if (item.error.empty())
+                item.result = job.engine->answer(item.query);
+            protocol.formatItem(item, text);
+        }
+        latency.record(chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - job.arrival).count());
+
+        // Only the first reply of a batch needs to wake the event loop
+        bool first;
+        {
+            lock_guard<mutex> lock(repliesMutex);
+            first = replies.empty();
+            replies.push_back({ job.connection, job.sequence, move(text) });
+            if (--jobsInFlight == 0)
+                jobsDone.notify_all();
+        }
+        job.engine.reset();
+        if (first)
+            wake();
+    }
+}
+
+
+// Function to run the server
+bool RoutingServer::run() {
+    if (pipe(wakePipe) != 0) {
+        cout << "Cannot create the wakeup pipe." << endl;
+        return false;
+    }
+    fcntl(wakePipe[0], F_SETFL, fcntl(wakePipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl(wakePipe[1], F_SETFL, fcntl(wakePipe[1], F_GETFL) | O_NONBLOCK);
+    if (!listenOn())
+        return false;
+
+    stopRequested = 0;
+    reloadRequested = 0;
+    signalWakeFd = wakePipe[1];
+    signal(SIGINT, handleStop);
+    signal(SIGTERM, handleStop);
+    signal(SIGHUP, handleReload);
+    signal(SIGPIPE, SIG_IGN);
+
+    for (int w = 0; w < threadCount; w++)
+        workers.push_back(thread([this]() { workerLoop(); }));
+    cout << "Serving " << currentEngine()->getNumberOfLocations() << " locations on " << address << " with "
+         << threadCount << " workers." << endl;
+
+    vector<pollfd> polled;
+    vector<uint64_t> polledIds;
+    while (!stopRequested) {
+        polled.clear();
+        polledIds.clear();
+        polled.push_back({ wakePipe[0], POLLIN, 0 });
+        polled.push_back({ listener, POLLIN, 0 });
+        for (map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end(); it++) {
+            Connection& connection = it->second;
+            short events = 0;
+            if (!connection.closing && connection.nextSequence - connection.nextReply < maxInFlight)
+                events |= POLLIN;
+            if (!connection.output.empty())
+                events |= POLLOUT;
+            // A negative descriptor is skipped by poll, so an idle closing connection cannot spin on POLLHUP
+            polled.push_back({ events == 0 ? -1 : connection.fd, events, 0 });
+            polledIds.push_back(it->first);
+        }
+
+        if (poll(polled.data(), polled.size(), -1) < 0 && errno != EINTR) {
+            cout << "poll failed: " << strerror(errno) << endl;
+            break;
+        }
+
+        if (polled[0].revents & POLLIN) {
+            char drain[256];
+            while (read(wakePipe[0], drain, sizeof(drain)) > 0) {}
+            collectReplies();
+        }
+        if (reloadRequested) {
+            reloadRequested = 0;
+            startReload();
+        }
+        if (polled[1].revents & POLLIN)
+            acceptConnections();
+
+        for (size_t k = 2; k < polled.size(); k++) {
+            Connection& connection = connections[polledIds[k - 2]];
+            if (polled[k].revents & (POLLIN | POLLHUP | POLLERR))
+                readConnection(polledIds[k - 2], connection);
+            if (!connection.output.empty())
+                writeConnection(connection);
+        }
+
+        // A connection is closed once the client stopped sending and every reply has been sent
+        for (map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end();) {
+            Connection& connection = it->second;
+            if (connection.closing && connection.nextReply == connection.nextSequence && connection.output.empty()) {
+                close(connection.fd);
+                it = connections.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+
+    // Graceful stop: no new clients, finish the queued requests, send their replies
+    close(listener);
+    listener = -1;
+    jobs.close();
+    for (thread& worker : workers)
+        worker.join();
+    workers.clear();
+    collectReplies();
+    for (map<uint64_t, Connection>::iterator it = connections.begin(); it != connections.end(); it++) {
+        fcntl(it->second.fd, F_SETFL, fcntl(it->second.fd, F_GETFL) & ~O_NONBLOCK);
+        writeConnection(it->second);
+    }
+
+    signalWakeFd = -1;
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTERM, SIG_DFL);
+    signal(SIGHUP, SIG_DFL);
+    cout << "Server stopped after " << latency.total() << " requests." << endl;
+    return true;
+}
+
+#endif /* RoutingServer_h */
@@ -0,0 +1,219 @@
+//
+//  StationTable.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef StationTable_h
+#define StationTable_h
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+
+#include "Location.h"
+
+using namespace std;
+
+// Class definition for StationTable, the locations stored column by column: a charger
+// bitset, a price array and one pool holding every name. The query kernels below only
+// touch the columns they need and are written as straight loops over contiguous doubles
+// with no branches in the loop body, so the compiler can vectorise them. A permutation of
+// the stations sorted by price is kept up to date as prices change, instead of re-sorting
+class StationTable {
+private:
+    vector<bool> chargers;          // Bit i is set if location i has a charger
+    vector<double> prices;          // Price per kWh as given in the input (-1 when there is no charger)
+    vector<double> stationPrices;   // Price where there is a charger, NaN elsewhere
+    vector<double> paidPrices;      // Like stationPrices, but NaN at free stations too
+    string namePool;                // All names, back to back
+    vector<uint32_t> nameOffsets;   // Name i is namePool[nameOffsets[i], nameOffsets[i + 1])
+    vector<int> priceOrder;         // Locations with a charger, by (price, index)
+    vector<double> latitudes;       // Position in degrees (NaN where the input gives none)
+    vector<double> longitudes;
+
+    // Order used by priceOrder: cheapest first, ties by index
+    bool cheaper(int a, int b) const {
+        return prices[a] < prices[b] || (prices[a] == prices[b] && a < b);
+    }
+
+    // Recompute the kernel price columns of one location. NaN fails every comparison, so the
+    // kernels skip such a location whatever the sign of the amount (infinity times a negative
+    // amount would make it the cheapest)
+    void updateKernelPrices(int index) {
+        stationPrices[index] = chargers[index] ? prices[index] : NAN;
+        paidPrices[index] = (chargers[index] && prices[index] > 0) ? prices[index] : NAN;
+    }
+
+    // Smallest travelCost[k] + amount * price[candidates[k]] over the candidates, as a
+    // branch-free reduction with the prices gathered through the candidate list
+    static double minimumCandidateCost(const int* candidates, const double* travelCost, const double* price, double amount, int count) {
+        double best = HUGE_VAL;
+        for (int k = 0; k < count; k++) {
+            double cost = travelCost[k] + amount * price[candidates[k]];
+            best = cost < best ? cost : best;
+        }
+        return best;
+    }
+
+public:
+    // Build the table; location i has names[i], charger[i] and price[i], and is at
+    // (latitude[i], longitude[i]) if coordinates are given
+    void build(const vector<string>& names, const vector<bool>& charger, const vector<double>& price,
+               const vector<double>& latitude = vector<double>(), const vector<double>& longitude = vector<double>());
+
+    // Get the number of locations
+    int size() const {
+        return (int)prices.size();
+    }
+
+    // Column accessors
+    bool hasCharger(int index) const {
+        return chargers[index];
+    }
+    double price(int index) const {
+        return prices[index];
+    }
+    string_view name(int index) const {
+        return string_view(namePool).substr(nameOffsets[index], nameOffsets[index + 1] - nameOffsets[index]);
+    }
+
+    // Whole columns, for graph searches that take one flag or price per vertex
+    const vector<bool>& chargerFlags() const {
+        return chargers;
+    }
+    const vector<double>& priceColumn() const {
+        return prices;
+    }
+    const vector<double>& latitudeColumn() const {
+        return latitudes;
+    }
+    const vector<double>& longitudeColumn() const {
+        return longitudes;
+    }
+
+    // Get one row as a Location object, for printing
+    Location location(int index) const {
+        Location row;
+        row.index = index;
+        row.locationName = string(name(index));
+        row.chargerInstalled = chargers[index];
+        row.chargingPrice = prices[index];
+        row.latitude = latitudes[index];
+        row.longitude = longitudes[index];
+        return row;
+    }
+
+    // Get the locations with a charger, cheapest first
+    const vector<int>& byPrice() const {
+        return priceOrder;
+    }
+
+    // Change the charger of a location, moving it within the price order. Returns false if
+    // there is no such location
+    bool update(int index, bool installed, double price);
+
+    // Get every location with a charger costing at most maxPrice per kWh, in index order
+    vector<int> chargersUnderPrice(double maxPrice) const;
+
+    // Get the candidate minimising travelCost[k] + amount * price(candidates[k]), where
+    // travelCost[k] belongs to candidates[k]. Free stations only count while amount is at most
+    // freeLimit. Returns -1 if no candidate is usable
+    int cheapestCandidate(const int* candidates, const double* travelCost, int count, double amount, double freeLimit, double& bestCost) const;
+};
+
+
+// Function to build the table from per-location rows
+void StationTable::build(const vector<string>& names, const vector<bool>& charger, const vector<double>& price,
+                         const vector<double>& latitude, const vector<double>& longitude) {
+    int n = (int)names.size();
+    chargers = charger;
+    prices = price;
+    latitudes = latitude;
+    longitudes = longitude;
+    latitudes.resize(n, NAN);
+    longitudes.resize(n, NAN);
+    stationPrices.assign(n, NAN);
+    paidPrices.assign(n, NAN);
+
+    namePool.clear();
+    nameOffsets.assign(1, 0);
+    for (const string& name : names) {
+        namePool += name;
+        nameOffsets.push_back((uint32_t)namePool.size());
+    }
+
+    priceOrder.clear();
+    for (int i = 0; i < n; i++) {
+        updateKernelPrices(i);
+        if (chargers[i])
+            priceOrder.push_back(i);
+    }
+    sort(priceOrder.begin(), priceOrder.end(), [&](int a, int b) { return cheaper(a, b); });
+}
+
+
+// Function to change a charger
+// The location leaves the price order at its old position and is inserted at its new one,
+// both found by binary search, so the order never needs a full sort
+bool StationTable::update(int index, bool installed, double price) {
+    if (index < 0 || index >= size())
+        return false;
+
+    if (chargers[index]) {
+        vector<int>::iterator it = lower_bound(priceOrder.begin(), priceOrder.end(), index, [&](int a, int b) { return cheaper(a, b); });
+        priceOrder.erase(it);
+    }
+
+    chargers[index] = installed;
+    prices[index] = price;
+    updateKernelPrices(index);
+
+    if (installed) {
+        vector<int>::iterator it = lower_bound(priceOrder.begin(), priceOrder.end(), index, [&](int a, int b) { return cheaper(a, b); });
+        priceOrder.insert(it, index);
+    }
+    return true;
+}
+
+
+// Function to list the chargers at or under a price
+// Every index is written and the output position only advances on a match, so the loop has no branch
+vector<int> StationTable::chargersUnderPrice(double maxPrice) const {
+    int n = size();
+    vector<int> matches(n + 1);
+    int count = 0;
+
+    for (int i = 0; i < n; i++) {
+        matches[count] = i;
+        count += stationPrices[i] <= maxPrice;
+    }
+    matches.resize(count);
+    return matches;
+}
+
+
+// Function to find the cheapest station among candidates
+// The minimum is found by a branch-free reduction, then a second pass finds the first
+// candidate reaching it
+int StationTable::cheapestCandidate(const int* candidates, const double* travelCost, int count, double amount, double freeLimit, double& bestCost) const {
+    const double* price = (amount > freeLimit ? paidPrices : stationPrices).data();
+    double best = minimumCandidateCost(candidates, travelCost, price, amount, count);
+
+    if (best == HUGE_VAL)
+        return -1;
+
+    for (int k = 0; k < count; k++) {
+        if (travelCost[k] + amount * price[candidates[k]] == best) {
+            bestCost = best;
+            return candidates[k];
+        }
+    }
+    return -1;
+}
+
+#endif /* StationTable_h */
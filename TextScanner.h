@@ -0,0 +1,158 @@
+//
+//  TextScanner.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef TextScanner_h
+#define TextScanner_h
+
+#include <charconv>
+#include <string>
+#include <iostream>
+
+using namespace std;
+
+// Class definition for TextScanner, a forward-only tokenizer over text in memory (usually a
+// MappedFile). Numbers are parsed in place with from_chars, so nothing is allocated per token.
+// The scanner tracks the line and column of its position for error messages; after the first
+// error every read fails and the error is kept for reporting
+class TextScanner {
+private:
+    const char* position;   // Next character to read
+    const char* end;        // One past the last character
+    const char* lineStart;  // First character of the current line
+    int line;               // Current line number, starting at 1
+    const char* fileName;   // Used in error messages
+
+    bool failed;
+    int errorLine;
+    int errorColumn;
+    string errorMessage;
+
+public:
+    TextScanner(const char* text, size_t length, const char* fileName)
+        : position(text), end(text + length), lineStart(text), line(1), fileName(fileName),
+          failed(false), errorLine(0), errorColumn(0) {}
+
+    // Record an error at the current position (only the first error is kept)
+    bool fail(const string& message) {
+        if (!failed) {
+            failed = true;
+            errorLine = line;
+            errorColumn = (int)(position - lineStart) + 1;
+            errorMessage = message;
+        }
+        return false;
+    }
+
+    bool hasFailed() const {
+        return failed;
+    }
+
+    // Print the error as "Parse error in <file> at line L, column C: message"
+    void printError() const {
+        cout << "Parse error in " << fileName << " at line " << errorLine << ", column " << errorColumn
+             << ": " << errorMessage << endl;
+    }
+
+    // Check whether the whole text has been read
+    bool atEnd() const {
+        return position == end;
+    }
+
+    // Skip spaces and tabs (and carriage returns), but not line breaks
+    void skipBlanks() {
+        while (position != end && (*position == ' ' || *position == '\t' || *position == '\r'))
+            position++;
+    }
+
+    // Skip all whitespace, including line breaks
+    void skipWhitespace() {
+        while (position != end && (*position == ' ' || *position == '\t' || *position == '\r' || *position == '\n')) {
+            if (*position == '\n')
+                nextLine();
+            else
+                position++;
+        }
+    }
+
+    // Move past the line break at the current position
+    void nextLine() {
+        position++;
+        lineStart = position;
+        line++;
+    }
+
+    // Skip the rest of the current line, including its line break
+    void skipLine() {
+        while (position != end && *position != '\n')
+            position++;
+        if (position != end)
+            nextLine();
+    }
+
+    // Check whether only blanks are left on the current line
+    bool atEndOfLine() {
+        skipBlanks();
+        return position == end || *position == '\n';
+    }
+
+    // Peek at the next character (0 at the end of the text)
+    char peek() const {
+        return position == end ? 0 : *position;
+    }
+
+    // Read a number after optional whitespace (line breaks included if acrossLines is set)
+    template <class Number>
+    bool readNumber(Number& value, bool acrossLines = true) {
+        if (failed)
+            return false;
+        if (acrossLines)
+            skipWhitespace();
+        else
+            skipBlanks();
+
+        from_chars_result result = from_chars(position, end, value);
+        if (result.ec != errc() || (result.ptr != end && !isDelimiter(*result.ptr)))
+            return fail(position == end ? "unexpected end of file, expected a number" : "expected a number");
+
+        position = result.ptr;
+        return true;
+    }
+
+    // Read a field up to (not including) the delimiter or the end of the line.
+    // The field is returned as a pointer and length into the text; nothing is copied
+    bool readField(char delimiter, const char*& field, size_t& length) {
+        if (failed)
+            return false;
+        field = position;
+        while (position != end && *position != delimiter && *position != '\n')
+            position++;
+        length = position - field;
+
+        // Drop a carriage return left by Windows line endings
+        if (length > 0 && field[length - 1] == '\r')
+            length--;
+        return true;
+    }
+
+    // Consume the expected character
+    bool expect(char expected) {
+        if (failed)
+            return false;
+        if (position == end || *position != expected)
+            return fail(string("expected '") + expected + "'");
+        position++;
+        return true;
+    }
+
+private:
+    // Characters that may end a number
+    static bool isDelimiter(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',';
+    }
+};
+
+#endif /* TextScanner_h */
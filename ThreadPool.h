@@ -0,0 +1,110 @@
+//
+//  ThreadPool.h
+//  20591029
+//
+//  Created by Shreya Wagley
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <algorithm>
+
+using namespace std;
+
+// Class definition for ThreadPool, a fixed set of worker threads that are started once
+// and reused for every parallel job. Each worker has a stable index, so callers can give
+// every worker its own scratch buffers
+class ThreadPool {
+private:
+    vector<thread> workers;             // The worker threads
+    mutex jobMutex;                     // Serialises jobs submitted from different threads
+    mutex stateMutex;                   // Guards the fields below
+    condition_variable wakeWorkers;     // Signalled when a new job is posted or the pool stops
+    condition_variable jobFinished;     // Signalled when the last worker finishes a job
+    const function<void(int)>* job;     // Job being run (nullptr when idle)
+    long generation;                    // Incremented for every job, so workers run each job once
+    int running;                        // Workers still busy with the current job
+    bool stopping;                      // Set by the destructor
+
+    // Main loop of a worker: wait for a job, run it, report back
+    void workerLoop(int worker) {
+        long seen = 0;
+        while (true) {
+            const function<void(int)>* current;
+            {
+                unique_lock<mutex> lock(stateMutex);
+                wakeWorkers.wait(lock, [&]() { return stopping || generation != seen; });
+                if (stopping)
+                    return;
+                seen = generation;
+                current = job;
+            }
+
+            (*current)(worker);
+
+            unique_lock<mutex> lock(stateMutex);
+            if (--running == 0)
+                jobFinished.notify_all();
+        }
+    }
+
+public:
+    // Start the given number of workers (0 = one per hardware thread)
+    ThreadPool(int threads = 0) : job(nullptr), generation(0), running(0), stopping(false) {
+        if (threads <= 0)
+            threads = max(1, (int)thread::hardware_concurrency());
+        for (int t = 0; t < threads; t++)
+            workers.push_back(thread(&ThreadPool::workerLoop, this, t));
+    }
+
+    // Stop and join every worker
+    ~ThreadPool() {
+        {
+            unique_lock<mutex> lock(stateMutex);
+            stopping = true;
+        }
+        wakeWorkers.notify_all();
+        for (thread& t : workers)
+            t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Get the number of workers
+    int size() const {
+        return (int)workers.size();
+    }
+
+    // Run job(worker) once on every worker and wait until all of them return
+    void runOnAllWorkers(const function<void(int)>& task) {
+        lock_guard<mutex> serialise(jobMutex);
+
+        unique_lock<mutex> lock(stateMutex);
+        job = &task;
+        running = (int)workers.size();
+        generation++;
+        wakeWorkers.notify_all();
+        jobFinished.wait(lock, [&]() { return running == 0; });
+        job = nullptr;
+    }
+
+    // Run body(worker, index) for every index in [0, count), spread over the workers.
+    // Indices are handed out one at a time, so uneven tasks still balance
+    void parallelFor(int count, const function<void(int, int)>& body) {
+        atomic<int> nextIndex(0);
+        runOnAllWorkers([&](int worker) {
+            for (int index = nextIndex++; index < count; index = nextIndex++)
+                body(worker, index);
+        });
+    }
+};
+
+#endif /* ThreadPool_h */
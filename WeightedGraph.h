@@ -15,58 +15,473 @@
 #include <stack>
 #include <list>
 #include <vector>
+#include <queue>
+#include <functional>
+#include <string>
+#include <algorithm>
+#include <memory>
+#include <cmath>
+#include <cstdint>
 
 using namespace std;
 
+#include "ThreadPool.h"
+#include "MappedFile.h"
+#include "TextScanner.h"
+#include "Instrumentation.h"
+#include "PriorityQueues.h"
+
+// Supported formats for the graph input file
+enum GraphFileFormat {
+    ADJACENCY_MATRIX, // gSize rows of gSize weights, 0 meaning no direct connection (Weights.txt)
+    EDGE_LIST         // One "from to weight" line per directed edge, '#' starts a comment line
+};
+
+// Non-owning view of a run of elements, such as the row of one vertex in the CSR arrays
+// (standing in for C++20's std::span). It stays valid until the graph's edges are replaced
+template <class Element>
+class Span {
+private:
+    const Element* first;
+    const Element* last;
+
+public:
+    Span(const Element* first, const Element* last) : first(first), last(last) {}
+
+    const Element* begin() const {
+        return first;
+    }
+    const Element* end() const {
+        return last;
+    }
+    size_t size() const {
+        return last - first;
+    }
+    bool empty() const {
+        return first == last;
+    }
+    const Element& operator[](size_t k) const {
+        return first[k];
+    }
+};
+
+// Result of a single-source search: the distance to and predecessor of every vertex.
+// Paths to any vertex can be read back from the tree without searching again
+class ShortestPathTree {
+public:
+    int source;                // Vertex the search started from
+    vector<double> distance;   // Smallest weight from the source (DBL_MAX if unreachable)
+    vector<int> predecessor;   // Previous vertex on the shortest path (-1 for the source and unreachable vertices)
+
+    // Check whether a vertex can be reached from the source
+    bool reachable(int vertex) const {
+        return distance[vertex] < DBL_MAX;
+    }
+
+    // Get the smallest weight from the source to a vertex
+    double distanceTo(int vertex) const {
+        return distance[vertex];
+    }
+
+    // Get the path from the source to a vertex, with the source on top of the stack.
+    // If the vertex is unreachable the stack only holds the vertex itself
+    stack<int> pathTo(int vertex) const {
+        stack<int> pathStack;
+        pathStack.push(vertex);
+
+        if (!reachable(vertex))
+            return pathStack;
+
+        // Follow the predecessors back to the source
+        while (vertex != source) {
+            vertex = predecessor[vertex];
+            pathStack.push(vertex);
+        }
+        return pathStack;
+    }
+
+    // Same as above, writing the path source first into an existing vector (reusing its buffer)
+    void pathTo(int vertex, vector<int>& path) const {
+        path.clear();
+        path.push_back(vertex);
+
+        if (reachable(vertex)) {
+            while (vertex != source) {
+                vertex = predecessor[vertex];
+                path.push_back(vertex);
+            }
+        }
+        reverse(path.begin(), path.end());
+    }
+};
+
+// Scratch buffers for one search. A worker keeps its workspace between searches,
+// so once the buffers have grown to the graph size no search allocates again
+class DijkstraWorkspace {
+public:
+    vector<pair<double, int>> heap; // Binary min-heap of (weight, vertex), managed with push_heap/pop_heap
+    ShortestPathTree tree;          // Tree buffer for callers that only need to look at the result
+
+    // Distances and predecessors for searches that stop early. An entry is only valid if its
+    // stamp matches the current generation, so starting a search costs O(1) instead of O(V)
+    vector<double> distance;
+    vector<int> predecessor;
+    vector<unsigned> stamp;
+    unsigned generation = 0;
+    long settled = 0; // Vertices settled by the last point-to-point search, for comparing solvers
+
+    // Start a new search over a graph of the given size
+    void newSearch(int size) {
+        if ((int)stamp.size() != size) {
+            distance.resize(size);
+            predecessor.resize(size);
+            stamp.assign(size, 0);
+        }
+        if (++generation == 0) { // Wrapped around: old stamps could look current again
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        heap.clear();
+        settled = 0;
+    }
+
+    // Get the tentative distance of a vertex in the current search (DBL_MAX if not reached)
+    double distanceOf(int v) const {
+        return stamp[v] == generation ? distance[v] : DBL_MAX;
+    }
+
+    // Set the tentative distance of a vertex in the current search
+    void setDistance(int v, double weight) {
+        stamp[v] = generation;
+        distance[v] = weight;
+    }
+
+    // Set the tentative distance of a vertex and the vertex it was reached from
+    void setDistance(int v, double weight, int from) {
+        stamp[v] = generation;
+        distance[v] = weight;
+        predecessor[v] = from;
+    }
+
+    // Get the vertex a reached vertex was reached from (-1 for the source)
+    int predecessorOf(int v) const {
+        return predecessor[v];
+    }
+};
+
+// Scratch buffers for one search over the fixed-point road distances, with a priority queue of
+// type Queue (see PriorityQueues.h). Distances are integer multiples of 1 / the graph's scale
+template <class Queue>
+class FixedPointWorkspace {
+public:
+    Queue queue;
+
+    // Distances and predecessors, valid where the stamp matches the generation (as in DijkstraWorkspace)
+    vector<uint64_t> distance;
+    vector<int> predecessor;
+    vector<unsigned> stamp;
+    unsigned generation = 0;
+    long settled = 0;
+
+    // Start a new search over a graph of the given size whose largest edge weight is largestStep
+    void newSearch(int size, uint64_t largestStep) {
+        if ((int)stamp.size() != size) {
+            distance.resize(size);
+            predecessor.resize(size);
+            stamp.assign(size, 0);
+        }
+        if (++generation == 0) {
+            fill(stamp.begin(), stamp.end(), 0);
+            generation = 1;
+        }
+        queue.reset(largestStep);
+        settled = 0;
+    }
+
+    // Get the tentative distance of a vertex in the current search (UINT64_MAX if not reached)
+    uint64_t distanceOf(int v) const {
+        return stamp[v] == generation ? distance[v] : UINT64_MAX;
+    }
+
+    // Set the tentative distance of a vertex and the vertex it was reached from
+    void setDistance(int v, uint64_t weight, int from) {
+        stamp[v] = generation;
+        distance[v] = weight;
+        predecessor[v] = from;
+    }
+};
+
 class WeightedGraphType {
 protected:
     int gSize;      //number of vertices
-    list<int> *graph; // Store adjacency list
-    double **weights; // Store weights of edges
+
+    // Sparse edge store in compressed sparse row (CSR) form, O(V + E) memory.
+    // The edges leaving vertex v are stored at [edgeOffsets[v], edgeOffsets[v + 1]),
+    // with the targets of each row sorted in ascending order
+    vector<int> edgeOffsets;    // gSize + 1 offsets into edgeTargets/edgeWeights
+    vector<int> edgeTargets;    // Head vertex of every edge, grouped by tail vertex
+    vector<double> edgeWeights; // Weight of every edge, parallel to edgeTargets
+
+    // Reverse index: the edges entering vertex v are reverseEdges[reverseOffsets[v] .. reverseOffsets[v + 1]),
+    // given as forward edge ids (so weights are only stored once), with their tails in reverseSources
+    vector<int> reverseOffsets;
+    vector<int> reverseEdges;
+    vector<int> reverseSources;
+
+    // Positions of the vertices as unit vectors from the centre of the earth (x, y, z per vertex;
+    // empty when the graph has no coordinates), and the largest factor that the straight-line
+    // distance between the ends of any road can be multiplied by without exceeding its length
+    vector<double> positions;
+    double lowerBoundScale;
+    static constexpr double earthRadius = 6371.0088; // Mean radius in km
+
+    // Get the straight-line distance in km between two vertices with coordinates
+    double straightLine(int a, int b) const {
+        const double* p = &positions[3 * (size_t)a];
+        const double* q = &positions[3 * (size_t)b];
+        double dx = p[0] - q[0], dy = p[1] - q[1], dz = p[2] - q[2];
+        return earthRadius * sqrt(dx * dx + dy * dy + dz * dz);
+    }
+    // Recompute lowerBoundScale from every road
+    void updateLowerBoundScale();
+
+    // Build the reverse index from the CSR arrays
+    void buildReverseIndex();
+    // Read the adjacency matrix format row by row, without materialising the matrix
+    bool readAdjacencyMatrix(TextScanner& scanner);
+    // Read the edge list format and sort it into compressed rows
+    bool readEdgeList(TextScanner& scanner);
+    // Find the edge id of i -> j, or -1 if there is no direct connection
+    int findEdge(int i, int j);
+
+    // Worker pool and per-worker scratch buffers for batch queries, created on first use
+    unique_ptr<ThreadPool> workerPool;
+    vector<DijkstraWorkspace> workerWorkspaces;
+    int workerThreads; // Size of the pool (0 = one per hardware thread)
+
+    // Start the worker pool if it is not running yet
+    ThreadPool& batchPool();
+
+    // Workspace for single queries, one per thread so queries from different threads can run
+    // at the same time (newSearch resizes it for whichever graph uses it)
+    static DijkstraWorkspace& queryWorkspace() {
+        static thread_local DijkstraWorkspace workspace;
+        return workspace;
+    }
+    // Second workspace of the calling thread, for the backward half of a bidirectional search
+    static DijkstraWorkspace& backwardWorkspace() {
+        static thread_local DijkstraWorkspace workspace;
+        return workspace;
+    }
+
+    // Road distances as integer multiples of 1 / fixedPointScale, parallel to edgeWeights
+    // (empty and a scale of 0 when useFixedPointWeights is off). Closed roads hold closedRoad
+    vector<uint32_t> fixedWeights;
+    int fixedPointScale;
+    uint64_t largestFixedWeight; // Largest open road, the step Dial's buckets have to cover
+    static constexpr uint32_t closedRoad = UINT32_MAX;
+
+    // Convert a road distance to the fixed-point scale. Returns false if it is not a whole
+    // multiple of 1 / scale or is too long
+    static bool toFixedPoint(double weight, int scale, uint32_t& fixed);
+    // Workspace of the calling thread for fixed-point searches with a Queue
+    template <class Queue>
+    static FixedPointWorkspace<Queue>& fixedPointWorkspace() {
+        static thread_local FixedPointWorkspace<Queue> workspace;
+        return workspace;
+    }
+    // Search the fixed-point weights from origin until destination is settled (-1: until every
+    // reachable vertex is), leaving the distances and predecessors in workspace
+    template <class Queue>
+    void fixedPointSearch(int origin, int destination, FixedPointWorkspace<Queue>& workspace);
 public:
     // Constructor: Initializes the weighted graph with the given size (default is 0)
-    WeightedGraphType(int size = 0);
+    // and reads the edges from the given file (default is the Weights.txt adjacency matrix).
+    // For EDGE_LIST files a size of 0 means "largest vertex index in the file + 1".
+    // A null file name gives an empty graph. Parse errors are reported with their line and column
+    WeightedGraphType(int size = 0, const char* fileName = "Weights.txt", GraphFileFormat format = ADJACENCY_MATRIX);
     // Destructor: Deallocates memory used by the weighted graph
     ~WeightedGraphType();
 
-    // Get the adjacency list for a given vertex index
-    list<int> getAdjancencyList(int index) {
-        return graph[index];
+    // Get the adjacency list for a given vertex index, as a view of its CSR row (nothing is copied)
+    Span<int> getAdjancencyList(int index) const {
+        return Span<int>(edgeTargets.data() + edgeOffsets[index], edgeTargets.data() + edgeOffsets[index + 1]);
+    }
+    // Get the weights of the edges leaving a vertex, parallel to getAdjancencyList
+    Span<double> getAdjacentWeights(int index) const {
+        return Span<double>(edgeWeights.data() + edgeOffsets[index], edgeWeights.data() + edgeOffsets[index + 1]);
     }
-    // Get the weight of the edge between vertices i and j
+    // Get the weight of the edge between vertices i and j (DBL_MAX if there is no direct connection)
     double getWeight(int i, int j) {
-        return weights[i][j];
+        int e = findEdge(i, j);
+        return e == -1 ? DBL_MAX : edgeWeights[e];
+    }
+    // Get the number of vertices in the graph
+    int getNumberOfVertices() {
+        return gSize;
+    }
+    // Get the number of directed edges in the graph
+    int getNumberOfEdges() {
+        return (int)edgeTargets.size();
+    }
+    // CSR accessors: the edges leaving v are the edge ids in [edgeBegin(v), edgeEnd(v))
+    int edgeBegin(int v) {
+        return edgeOffsets[v];
+    }
+    int edgeEnd(int v) {
+        return edgeOffsets[v + 1];
+    }
+    // Get the head vertex of an edge id
+    int edgeTarget(int e) {
+        return edgeTargets[e];
+    }
+    // Get the weight of an edge id
+    double edgeWeight(int e) {
+        return edgeWeights[e];
+    }
+    // Reverse accessors: the edges entering v are at positions [reverseEdgeBegin(v), reverseEdgeEnd(v))
+    int reverseEdgeBegin(int v) {
+        return reverseOffsets[v];
+    }
+    int reverseEdgeEnd(int v) {
+        return reverseOffsets[v + 1];
+    }
+    // Get the forward edge id stored at a reverse position
+    int reverseEdgeId(int k) {
+        return reverseEdges[k];
+    }
+    // Get the tail vertex of the edge stored at a reverse position
+    int reverseEdgeSource(int k) {
+        return reverseSources[k];
+    }
+    // Change the weight of the existing edge i -> j; DBL_MAX closes the road.
+    // Returns false if there is no such edge (new roads cannot be added in place). A weight the
+    // fixed-point scale cannot hold turns the fixed-point weights off (see hasFixedPointWeights)
+    bool updateEdgeWeight(int i, int j, double weight);
+    // Repair a shortest path tree after the weight of edge from -> to changed from oldWeight.
+    // Only the vertices whose distance actually changes are searched again: after an increase
+    // on a tree edge, the subtree below it; after a decrease, the vertices it improves
+    void repairShortestPathTree(ShortestPathTree& tree, int from, int to, double oldWeight);
+    // Replace all edges with compressed rows (targets sorted within each row)
+    bool setEdges(int size, vector<int> offsets, vector<int> targets, vector<double> weights);
+    // Get the CSR arrays, for writing snapshots
+    const vector<int>& getEdgeOffsets() const {
+        return edgeOffsets;
+    }
+    const vector<int>& getEdgeTargets() const {
+        return edgeTargets;
+    }
+    const vector<double>& getEdgeWeights() const {
+        return edgeWeights;
     }
     // Print the adjacency list of the graph
     void printAdjacencyList();
     // Print the adjacency matrix of the graph
     void printAdjacencyMatrix();
+    // Write the graph in the EDGE_LIST format
+    bool writeEdgeList(const char* fileName);
+    // Find the shortest path tree from the specified index (binary heap over CSR, O(E log V))
+    ShortestPathTree shortestPathTree(int index);
+    // Same as above, writing into an existing tree and reusing the workspace buffers
+    void shortestPathTree(int index, ShortestPathTree& tree, DijkstraWorkspace& workspace);
+    // Find the k closest vertices to index (other than index itself) with isTarget set, nearest first.
+    // The search stops as soon as the k-th target is settled, so its cost depends on how
+    // dense the targets are around index rather than on the size of the graph
+    vector<pair<int, double>> nearestTargets(int index, const vector<bool>& isTarget, int k);
+    // Same as above, writing into an existing vector (reusing its buffer)
+    void nearestTargets(int index, const vector<bool>& isTarget, int k, vector<pair<int, double>>& found);
+    // Find the closest vertex to index with isTarget set (-1 if none is reachable)
+    int nearestTarget(int index, const vector<bool>& isTarget, double& distance);
+    // Set the number of worker threads used by batch queries (0 = one per hardware thread)
+    void setWorkerThreads(int threads);
+    // Batch query: one independent search per source, spread over the worker pool.
+    // Results are in the same order as the sources; passing the same results vector
+    // again reuses its buffers
+    void shortestPaths(const vector<int>& sources, vector<ShortestPathTree>& results);
+    vector<ShortestPathTree> shortestPaths(const vector<int>& sources);
+    // Batch query that hands each tree to visit(position, tree) on the worker thread that
+    // computed it, without keeping the trees. visit must be safe to call concurrently
+    void forEachShortestPathTree(const vector<int>& sources, const function<void(int, const ShortestPathTree&)>& visit);
+    // Find the shortest path from every vertex to the specified index, searching the reverse index.
+    // The tree's distance is the weight to index and its predecessor the next vertex on the way there
+    void reverseShortestPathTree(int index, ShortestPathTree& tree, DijkstraWorkspace& workspace);
     // Find the shortest path from the specified index to all other vertices
     vector<double> shortestPath(int index);
+    // Same as shortestPath(int), using the original O(V^2) dense scan; kept as a reference for benchmarks
+    vector<double> shortestPathDense(int index);
     // Find the shortest path from origin to destination using a stack
     stack<int> shortestPath(int origin, int destination);
+    // Find the shortest path from origin to destination with a search that stops once the
+    // destination is settled, writing it origin first into path (reusing its buffer).
+    // Returns its weight, or DBL_MAX with an empty path if the destination is unreachable.
+    // When the graph has coordinates this is an A* search, which settles far fewer vertices
+    double shortestPath(int origin, int destination, vector<int>& path);
+    // Same as above, always searching in every direction; kept as a reference for benchmarks
+    double shortestPathDijkstra(int origin, int destination, vector<int>& path);
+    // Same as above, searching forward from origin and backward from destination at the same
+    // time until the two searches meet. Of several equally short paths it may return another
+    // than shortestPathDijkstra
+    double shortestPathBidirectional(int origin, int destination, vector<int>& path);
+    // Same as above, as an A* search guided by bound(v), a lower bound of the distance from v to
+    // the destination that must never exceed it (LandmarkIndex supplies one for graphs without coordinates)
+    template <class LowerBound>
+    double shortestPathGuided(int origin, int destination, vector<int>& path, const LowerBound& bound);
+    // Keep a copy of the road distances scaled to integers (scale 10 keeps the one decimal place
+    // of Weights.txt exactly) for shortestPathFixed and shortestPathTreeFixed; 0 drops it.
+    // Returns false, and turns it off, if some road is not a whole multiple of 1 / scale
+    bool useFixedPointWeights(int scale = 10);
+    // Check whether the fixed-point searches can be used
+    bool hasFixedPointWeights() const {
+        return fixedPointScale > 0;
+    }
+    // Same as shortestPathTree, over the fixed-point weights with a priority queue of type Queue
+    // (BinaryHeapQueue, QuaternaryHeapQueue, RadixHeapQueue or DialQueue). Sums of integers are
+    // exact, so equal paths compare equal; the distances are converted back to km at the end.
+    // Returns false, leaving the tree unchanged, if the fixed-point weights are not in use
+    template <class Queue>
+    bool shortestPathTreeFixed(int index, ShortestPathTree& tree);
+    // Same as shortestPathDijkstra, over the fixed-point weights with a priority queue of type Queue.
+    // Returns DBL_MAX with an empty path if the fixed-point weights are not in use
+    template <class Queue>
+    double shortestPathFixed(int origin, int destination, vector<int>& path);
+    // Get the number of vertices the calling thread's last point-to-point search settled
+    static long lastSearchSettled() {
+        return queryWorkspace().settled;
+    }
+    // Place the vertices on the map, in degrees, for the A* lower bound. Returns false (and
+    // leaves the graph without coordinates) unless every vertex has a finite position
+    bool setCoordinates(const vector<double>& latitudes, const vector<double>& longitudes);
+    // Check whether shortestPath can use the A* lower bound
+    bool hasCoordinates() const {
+        return !positions.empty();
+    }
+    // Get a lower bound on the road distance between two vertices with coordinates, in km
+    double distanceLowerBound(int a, int b) const {
+        return lowerBoundScale * straightLine(a, b);
+    }
     
 };
 
 
 
 // Constructor for WeightedGraphType class
-// Initializes the weighted graph with the given size and reads the adjacency matrix from a file
-WeightedGraphType::WeightedGraphType(int size) {
+// Initializes the weighted graph with the given size and reads the edges from a file
+WeightedGraphType::WeightedGraphType(int size, const char* fileName, GraphFileFormat format) {
     gSize = 0; // Initialize the number of vertices to zero
-    ifstream infile; // Input file stream for reading from a file
-    char fileName[50] = "Weights.txt"; // Default file name for the adjacency matrix
-    
-    //uncomment if u want to use a file with different name
-    //    cout << "Enter graph adjacency matrix file name: ";
-    //    cin >> fileName;
-    //    cout << endl;
+    workerThreads = 0;
+    lowerBoundScale = 0;
+    fixedPointScale = 0;
+    largestFixedWeight = 0;
+    edgeOffsets.assign(1, 0); // An empty graph still has one offset
+    reverseOffsets.assign(1, 0);
 
-    // Open the file with the adjacency matrix
-    infile.open(fileName);
+    // No file name: start empty, for callers that fill the graph with setEdges
+    if (fileName == nullptr)
+        return;
 
-    // Check if the file is successfully opened
-    if (!infile) {
+    // Map the whole file into memory; it is parsed in place
+    MappedFile file;
+    if (!file.openReadOnly(fileName)) {
         cout << "Cannot open input file." << endl;
         return;
     }
@@ -74,52 +489,401 @@ WeightedGraphType::WeightedGraphType(int size) {
     // Set the graph size to the given size
     gSize = size;
 
-    // Allocate memory for the adjacency list and weights matrix
-    graph = new list<int>[gSize];
-    weights = new double *[gSize];
+    // Read the edges in the requested format
+    TextScanner scanner(file.data(), file.length(), fileName);
+    bool ok = (format == EDGE_LIST) ? readEdgeList(scanner) : readAdjacencyMatrix(scanner);
+
+    // Fall back to an empty graph rather than keeping a half-read one
+    if (!ok) {
+        scanner.printError();
+        gSize = 0;
+        edgeOffsets.assign(1, 0);
+        edgeTargets.clear();
+        edgeWeights.clear();
+    }
+
+    buildReverseIndex();
+}
+
+
+// Function to replace the edges with ready-made compressed rows (for example from a snapshot)
+// Returns false, leaving the graph unchanged, if the arrays are inconsistent
+bool WeightedGraphType::setEdges(int size, vector<int> offsets, vector<int> targets, vector<double> weights) {
+    if (size < 0 || (int)offsets.size() != size + 1 || offsets[0] != 0 || offsets[size] != (int)targets.size() ||
+        targets.size() != weights.size())
+        return false;
+    for (int v = 0; v < size; v++)
+        if (offsets[v] > offsets[v + 1])
+            return false;
+    for (int v = 0; v < size; v++)
+        for (int e = offsets[v]; e < offsets[v + 1]; e++)
+            if (targets[e] < 0 || targets[e] >= size || (e > offsets[v] && targets[e] <= targets[e - 1]))
+                return false;
+
+    // Coordinates only stay if the vertices are the same; the bound has to cover the new roads
+    if (size != gSize)
+        positions.clear();
+    gSize = size;
+    edgeOffsets.swap(offsets);
+    edgeTargets.swap(targets);
+    edgeWeights.swap(weights);
+    buildReverseIndex();
+    if (!positions.empty())
+        updateLowerBoundScale();
+    if (fixedPointScale > 0)
+        useFixedPointWeights(fixedPointScale);
+    return true;
+}
+
+
+// Function to scale the road distances to integers
+bool WeightedGraphType::useFixedPointWeights(int scale) {
+    fixedWeights.clear();
+    fixedPointScale = 0;
+    largestFixedWeight = 0;
+    if (scale <= 0)
+        return true;
+
+    fixedWeights.resize(edgeWeights.size());
+    for (size_t e = 0; e < edgeWeights.size(); e++) {
+        if (!toFixedPoint(edgeWeights[e], scale, fixedWeights[e])) {
+            fixedWeights.clear();
+            return false;
+        }
+        if (fixedWeights[e] != closedRoad)
+            largestFixedWeight = max(largestFixedWeight, (uint64_t)fixedWeights[e]);
+    }
+    fixedPointScale = scale;
+    return true;
+}
+
+
+// Function to convert a road distance to the fixed-point scale
+// A distance read as 8.5 is the double nearest to it, so weight * scale is only within rounding
+// of a whole number, and is rounded to it
+bool WeightedGraphType::toFixedPoint(double weight, int scale, uint32_t& fixed) {
+    if (weight == DBL_MAX) {
+        fixed = closedRoad;
+        return true;
+    }
+    double scaled = weight * scale;
+    double whole = nearbyint(scaled);
+    if (!(whole >= 0 && whole < (double)INT32_MAX) || fabs(scaled - whole) > 1e-6 * max(1.0, whole))
+        return false;
+    fixed = (uint32_t)whole;
+    return true;
+}
+
+
+// Function to place the vertices on the map
+bool WeightedGraphType::setCoordinates(const vector<double>& latitudes, const vector<double>& longitudes) {
+    positions.clear();
+    if ((int)latitudes.size() != gSize || (int)longitudes.size() != gSize)
+        return false;
+    for (int v = 0; v < gSize; v++)
+        if (!isfinite(latitudes[v]) || !isfinite(longitudes[v]))
+            return false;
+
+    positions.resize(3 * (size_t)gSize);
+    const double radians = acos(-1.0) / 180;
+    for (int v = 0; v < gSize; v++) {
+        double latitude = latitudes[v] * radians, longitude = longitudes[v] * radians;
+        positions[3 * (size_t)v] = cos(latitude) * cos(longitude);
+        positions[3 * (size_t)v + 1] = cos(latitude) * sin(longitude);
+        positions[3 * (size_t)v + 2] = sin(latitude);
+    }
+    updateLowerBoundScale();
+    return true;
+}
+
+
+// Function to find the smallest ratio of road length to straight-line distance
+// Any path is then at least lowerBoundScale times as long as the straight line between its
+// ends (by the triangle inequality, road by road), which makes the A* bound admissible and
+// consistent. The scale is shaved slightly so rounding can never push the bound over
+void WeightedGraphType::updateLowerBoundScale() {
+    double scale = DBL_MAX;
+    for (int v = 0; v < gSize; v++) {
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            double line = straightLine(v, edgeTargets[e]);
+            if (line > 0 && edgeWeights[e] < DBL_MAX)
+                scale = min(scale, edgeWeights[e] / line);
+        }
+    }
+    lowerBoundScale = scale == DBL_MAX ? 0 : scale * (1 - 1e-9);
+}
+
+
+// Function to build the reverse index of incoming edges (counting sort by head vertex)
+void WeightedGraphType::buildReverseIndex() {
+    reverseOffsets.assign(gSize + 1, 0);
+    for (int target : edgeTargets)
+        reverseOffsets[target + 1]++;
+    for (int v = 0; v < gSize; v++)
+        reverseOffsets[v + 1] += reverseOffsets[v];
+
+    reverseEdges.resize(edgeTargets.size());
+    reverseSources.resize(edgeTargets.size());
+    vector<int> next(reverseOffsets.begin(), reverseOffsets.end() - 1);
+
+    for (int v = 0; v < gSize; v++)
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int k = next[edgeTargets[e]]++;
+            reverseEdges[k] = e;
+            reverseSources[k] = v;
+        }
+}
+
+
+// Function to change the weight of an existing edge in place
+bool WeightedGraphType::updateEdgeWeight(int i, int j, double weight) {
+    int e = findEdge(i, j);
+    if (e == -1 || weight <= 0)
+        return false;
+
+    edgeWeights[e] = weight;
+
+    // A distance the fixed-point scale cannot hold turns the fixed-point searches off
+    if (fixedPointScale > 0) {
+        if (toFixedPoint(weight, fixedPointScale, fixedWeights[e])) {
+            if (fixedWeights[e] != closedRoad)
+                largestFixedWeight = max(largestFixedWeight, (uint64_t)fixedWeights[e]);
+        } else {
+            useFixedPointWeights(0);
+        }
+    }
+
+    // A shorter road may be shorter than the A* bound allows for
+    if (!positions.empty() && weight < DBL_MAX && straightLine(i, j) > 0)
+        lowerBoundScale = min(lowerBoundScale, weight / straightLine(i, j) * (1 - 1e-9));
+    return true;
+}
 
-    // Allocate memory for each row of the weights matrix
-    for (int i = 0; i < gSize; i++)
-        weights[i] = new double[gSize];
 
-    // Read the values from the file and populate the weights matrix and adjacency list
+// Function to repair a shortest path tree after one edge weight changed
+// Distances through a closed road (DBL_MAX) are treated as unreachable
+void WeightedGraphType::repairShortestPathTree(ShortestPathTree& tree, int from, int to, double oldWeight) {
+    EV_TIMER_LEG("repairShortestPathTree", from, to);
+    SearchCounters counters;
+    double weight = getWeight(from, to);
+    vector<pair<double, int>>& heap = queryWorkspace().heap;
+    greater<pair<double, int>> later;
+    heap.clear();
+
+    // Sum of two weights, saturating at DBL_MAX
+    auto add = [](double a, double b) {
+        return (a == DBL_MAX || b == DBL_MAX) ? DBL_MAX : a + b;
+    };
+
+    if (weight < oldWeight) {
+        // Decrease: only vertices that the cheaper edge improves can change
+        double through = add(tree.distance[from], weight);
+        if (through >= tree.distance[to])
+            return;
+        tree.distance[to] = through;
+        tree.predecessor[to] = from;
+        heap.push_back(make_pair(through, to));
+    } else if (weight > oldWeight) {
+        // Increase: only the subtree hanging from this edge can change
+        if (tree.predecessor[to] != from)
+            return;
+
+        // Collect the subtree by following tree edges down from `to`
+        vector<int> affected(1, to);
+        for (size_t k = 0; k < affected.size(); k++) {
+            int v = affected[k];
+            for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++)
+                if (tree.predecessor[edgeTargets[e]] == v)
+                    affected.push_back(edgeTargets[e]);
+        }
+
+        for (int v : affected) {
+            tree.distance[v] = DBL_MAX;
+            tree.predecessor[v] = -1;
+        }
+
+        // Give every affected vertex its best entry from outside the subtree
+        for (int v : affected) {
+            for (int k = reverseOffsets[v]; k < reverseOffsets[v + 1]; k++) {
+                int u = reverseSources[k];
+                double through = add(tree.distance[u], edgeWeights[reverseEdges[k]]);
+                if (through < tree.distance[v]) {
+                    tree.distance[v] = through;
+                    tree.predecessor[v] = u;
+                }
+            }
+            if (tree.distance[v] < DBL_MAX)
+                heap.push_back(make_pair(tree.distance[v], v));
+        }
+        make_heap(heap.begin(), heap.end(), later);
+    }
+
+    // Settle the changed vertices and push the changes outwards (plain Dijkstra from the seeds)
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), later);
+        double minWeight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        if (minWeight > tree.distance[v])
+            continue;
+        counters.settled++;
+        counters.relaxed += edgeOffsets[v + 1] - edgeOffsets[v];
+
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int j = edgeTargets[e];
+            double through = add(minWeight, edgeWeights[e]);
+
+            if (through < tree.distance[j]) {
+                tree.distance[j] = through;
+                tree.predecessor[j] = v;
+                heap.push_back(make_pair(through, j));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    }
+} //end repairShortestPathTree
+
+
+// Function to read an adjacency matrix into compressed rows
+// Rows arrive in vertex order and columns in ascending order, so every non-zero
+// value can be appended straight to the CSR arrays
+bool WeightedGraphType::readAdjacencyMatrix(TextScanner& scanner) {
+    edgeOffsets.assign(gSize + 1, 0);
+
     for (int i = 0; i < gSize; i++) {
         for (int j = 0; j < gSize; j++) {
             double value;
-            infile >> value;
-
-            // If the value is zero, set the weight to DBL_MAX (maximum value of double)
-            // Otherwise, set the weight to the read value and add the vertex to the adjacency list
-            if (value == 0)
-                weights[i][j] = DBL_MAX; // System constant representing the maximum value of double
-            else {
-                weights[i][j] = value;
-                graph[i].push_back(j);
+            if (!scanner.readNumber(value))
+                return false;
+            if (value < 0)
+                return scanner.fail("negative road length");
+
+            // A zero means no direct connection; anything else is an edge i -> j
+            if (value != 0) {
+                edgeTargets.push_back(j);
+                edgeWeights.push_back(value);
             }
         }
+        edgeOffsets[i + 1] = (int)edgeTargets.size();
+    }
+
+    return true;
+}
+
+
+// Function to read an edge list into compressed rows
+// Edges may appear in any order; they are bucketed by tail vertex (counting sort)
+// and each row is then sorted by head vertex. Duplicate edges keep the smallest weight
+bool WeightedGraphType::readEdgeList(TextScanner& scanner) {
+    vector<int> from, to;
+    vector<double> weight;
+    int largestIndex = -1;
+
+    // Read every "from to weight" line, skipping blank and comment lines
+    while (true) {
+        scanner.skipWhitespace();
+        if (scanner.atEnd())
+            break;
+        if (scanner.peek() == '#') {
+            scanner.skipLine();
+            continue;
+        }
+
+        int i, j;
+        double value;
+        if (!scanner.readNumber(i, false) || !scanner.readNumber(j, false) || !scanner.readNumber(value, false))
+            return false;
+        if (i < 0 || j < 0)
+            return scanner.fail("negative vertex index");
+        if (value <= 0)
+            return scanner.fail("road length must be positive");
+        if (gSize > 0 && max(i, j) >= gSize)
+            return scanner.fail("vertex index out of range");
+        if (!scanner.atEndOfLine())
+            return scanner.fail("expected the end of the line");
+
+        from.push_back(i);
+        to.push_back(j);
+        weight.push_back(value);
+        largestIndex = max(largestIndex, max(i, j));
     }
 
-    // Close the file after reading
-    infile.close();
+    // Work out the number of vertices if it was not given
+    if (gSize == 0)
+        gSize = largestIndex + 1;
+
+    // Count the edges of every row, then turn the counts into offsets
+    edgeOffsets.assign(gSize + 1, 0);
+    for (int i : from)
+        edgeOffsets[i + 1]++;
+    for (int v = 0; v < gSize; v++)
+        edgeOffsets[v + 1] += edgeOffsets[v];
+
+    // Scatter the edges into their rows
+    vector<int> next(edgeOffsets.begin(), edgeOffsets.end() - 1);
+    vector<pair<int, double>> rowEdges(from.size());
+    for (size_t k = 0; k < from.size(); k++)
+        rowEdges[next[from[k]]++] = make_pair(to[k], weight[k]);
+
+    // Sort each row by head vertex and drop duplicate edges
+    edgeTargets.clear();
+    edgeWeights.clear();
+    int written = 0;
+    for (int v = 0; v < gSize; v++) {
+        sort(rowEdges.begin() + edgeOffsets[v], rowEdges.begin() + edgeOffsets[v + 1]);
+        for (int k = edgeOffsets[v]; k < edgeOffsets[v + 1]; k++) {
+            // Sorted pairs put the smallest weight of a duplicate first
+            if (k > edgeOffsets[v] && rowEdges[k].first == rowEdges[k - 1].first)
+                continue;
+            edgeTargets.push_back(rowEdges[k].first);
+            edgeWeights.push_back(rowEdges[k].second);
+        }
+        edgeOffsets[v] = written;
+        written = (int)edgeTargets.size();
+    }
+    edgeOffsets[gSize] = written;
+
+    return true;
+}
+
+
+// Function to find the edge id of i -> j using a binary search over the sorted row of i
+int WeightedGraphType::findEdge(int i, int j) {
+    vector<int>::iterator rowBegin = edgeTargets.begin() + edgeOffsets[i];
+    vector<int>::iterator rowEnd = edgeTargets.begin() + edgeOffsets[i + 1];
+    vector<int>::iterator it = lower_bound(rowBegin, rowEnd, j);
+
+    if (it == rowEnd || *it != j)
+        return -1;
+    return (int)(it - edgeTargets.begin());
 }
 
 
 // Destructor for WeightedGraphType class
-// Deallocates the memory used for the weights matrix and adjacency list
+// The edge store is held in vectors, which release their own memory
 WeightedGraphType::~WeightedGraphType() {
-    // Deallocate memory for each row of the weights matrix
-    for (int i = 0; i < gSize; i++)
-        delete[] weights[i];
+}
+
 
-    // Deallocate memory for the weights matrix
-    delete[] weights;
+// Function to write the graph in the EDGE_LIST format, one directed edge per line
+bool WeightedGraphType::writeEdgeList(const char* fileName) {
+    ofstream outfile(fileName);
+
+    if (!outfile) {
+        cout << "Cannot open output file." << endl;
+        return false;
+    }
 
-    // Clear the adjacency list for each vertex
-    for (int index = 0; index < gSize; index++)
-        graph[index].clear();
+    outfile << setprecision(15); // Enough digits to read back the same weights
+    outfile << "# from to weight (" << gSize << " vertices, " << edgeTargets.size() << " edges)\n";
+    for (int v = 0; v < gSize; v++)
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++)
+            outfile << v << ' ' << edgeTargets[e] << ' ' << edgeWeights[e] << '\n';
 
-    // Deallocate memory for the adjacency list
-    delete[] graph;
+    return (bool)outfile;
 }
 
 
@@ -132,7 +896,8 @@ void WeightedGraphType::printAdjacencyMatrix() {
     for (int i = 0; i < gSize; i++) {
         for (int j = 0; j < gSize; j++) {
             // Display the weight value or 0 if the weight is DBL_MAX (no direct connection)
-            cout << setw(8) << (weights[i][j] == DBL_MAX ? 0.0 : weights[i][j]);
+            double weight = getWeight(i, j);
+            cout << setw(8) << (weight == DBL_MAX ? 0.0 : weight);
         }
         cout << endl;
     }
@@ -149,8 +914,8 @@ void WeightedGraphType::printAdjacencyList() {
         cout << index << ": ";
         
         // Display the adjacent vertices for the current vertex
-        for (int e : graph[index])
-            cout << e << " ";
+        for (int e = edgeOffsets[index]; e < edgeOffsets[index + 1]; e++)
+            cout << edgeTargets[e] << " ";
         
         cout << endl;
     }
@@ -159,15 +924,253 @@ void WeightedGraphType::printAdjacencyList() {
 }
 
 
+// Function to find the shortest path tree from a given vertex
+ShortestPathTree WeightedGraphType::shortestPathTree(int index) {
+    ShortestPathTree tree;
+    DijkstraWorkspace workspace;
+    shortestPathTree(index, tree, workspace);
+    return tree;
+} //end shortestPathTree
+
+
+// Function to find the shortest path tree from a given vertex into existing buffers
+// Uses a binary heap with lazy deletion over the CSR arrays, so a query costs O(E log V).
+// Predecessors are recorded while relaxing, so paths never need to be backtracked
+void WeightedGraphType::shortestPathTree(int index, ShortestPathTree& tree, DijkstraWorkspace& workspace) {
+    EV_TIMER("shortestPathTree");
+    SearchCounters counters;
+
+    // assign() keeps the existing capacity, so a reused tree is not reallocated
+    tree.source = index;
+    tree.distance.assign(gSize, DBL_MAX);
+    tree.predecessor.assign(gSize, -1);
+
+    // Min-heap of (weight, vertex) pairs; stale entries are skipped when popped
+    vector<pair<double, int>>& heap = workspace.heap;
+    greater<pair<double, int>> later;
+    heap.clear();
+
+    tree.distance[index] = 0;
+    heap.push_back(make_pair(0.0, index));
+    counters.pushes++;
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), later);
+        double minWeight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        // Skip entries that were superseded by a shorter path
+        if (minWeight > tree.distance[v])
+            continue;
+        counters.settled++;
+        counters.relaxed += edgeOffsets[v + 1] - edgeOffsets[v];
+
+        // Relax the edges leaving v
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int j = edgeTargets[e];
+            double weight = minWeight + edgeWeights[e];
+
+            if (weight < tree.distance[j]) {
+                tree.distance[j] = weight;
+                tree.predecessor[j] = v;
+                heap.push_back(make_pair(weight, j));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    } //end while
+} //end shortestPathTree
+
+
+// Function to find the shortest path tree into a given vertex
+// The same search as shortestPathTree, following the edges entering each vertex backwards
+void WeightedGraphType::reverseShortestPathTree(int index, ShortestPathTree& tree, DijkstraWorkspace& workspace) {
+    EV_TIMER("reverseShortestPathTree");
+    SearchCounters counters;
+
+    tree.source = index;
+    tree.distance.assign(gSize, DBL_MAX);
+    tree.predecessor.assign(gSize, -1);
+
+    vector<pair<double, int>>& heap = workspace.heap;
+    greater<pair<double, int>> later;
+    heap.clear();
+
+    tree.distance[index] = 0;
+    heap.push_back(make_pair(0.0, index));
+    counters.pushes++;
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), later);
+        double minWeight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        if (minWeight > tree.distance[v])
+            continue;
+        counters.settled++;
+        counters.relaxed += reverseOffsets[v + 1] - reverseOffsets[v];
+
+        // Relax the edges entering v
+        for (int k = reverseOffsets[v]; k < reverseOffsets[v + 1]; k++) {
+            int u = reverseSources[k];
+            double weight = minWeight + edgeWeights[reverseEdges[k]];
+
+            if (weight < tree.distance[u]) {
+                tree.distance[u] = weight;
+                tree.predecessor[u] = v;
+                heap.push_back(make_pair(weight, u));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    } //end while
+} //end reverseShortestPathTree
+
+
+// Function to find the k nearest target vertices with a search that stops early
+// Vertices are settled in order of distance (ties by vertex index), so the first k
+// targets settled are the k nearest
+vector<pair<int, double>> WeightedGraphType::nearestTargets(int index, const vector<bool>& isTarget, int k) {
+    vector<pair<int, double>> found;
+    nearestTargets(index, isTarget, k, found);
+    return found;
+}
+
+
+void WeightedGraphType::nearestTargets(int index, const vector<bool>& isTarget, int k, vector<pair<int, double>>& found) {
+    EV_TIMER("nearestTargets");
+    SearchCounters counters;
+    DijkstraWorkspace& workspace = queryWorkspace();
+    vector<pair<double, int>>& heap = workspace.heap;
+    greater<pair<double, int>> later;
+
+    found.clear();
+    if (k <= 0)
+        return;
+
+    workspace.newSearch(gSize);
+    workspace.setDistance(index, 0);
+    heap.push_back(make_pair(0.0, index));
+    counters.pushes++;
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), later);
+        double minWeight = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        // Skip entries that were superseded by a shorter path
+        if (minWeight > workspace.distanceOf(v))
+            continue;
+        counters.settled++;
+
+        // v is settled; stop once enough targets have been found
+        if (v != index && isTarget[v]) {
+            found.push_back(make_pair(v, minWeight));
+            if ((int)found.size() == k)
+                break;
+        }
+
+        // Relax the edges leaving v
+        counters.relaxed += edgeOffsets[v + 1] - edgeOffsets[v];
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int j = edgeTargets[e];
+            double weight = minWeight + edgeWeights[e];
+
+            if (weight < workspace.distanceOf(j)) {
+                workspace.setDistance(j, weight);
+                heap.push_back(make_pair(weight, j));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            }
+        }
+    } //end while
+} //end nearestTargets
+
+
+int WeightedGraphType::nearestTarget(int index, const vector<bool>& isTarget, double& distance) {
+    static thread_local vector<pair<int, double>> found;
+    nearestTargets(index, isTarget, 1, found);
+
+    if (found.empty()) {
+        distance = DBL_MAX;
+        return -1;
+    }
+    distance = found[0].second;
+    return found[0].first;
+}
+
+
+// Function to set the size of the batch worker pool
+// A running pool of a different size is stopped and restarted on the next batch
+void WeightedGraphType::setWorkerThreads(int threads) {
+    if (threads != workerThreads) {
+        workerThreads = threads;
+        workerPool.reset();
+    }
+}
+
+
+// Function to start the batch worker pool and give every worker a workspace
+ThreadPool& WeightedGraphType::batchPool() {
+    if (!workerPool) {
+        workerPool.reset(new ThreadPool(workerThreads));
+        workerWorkspaces.resize(workerPool->size());
+    }
+    return *workerPool;
+}
+
+
+// Function to run one search per source across the worker pool
+// Worker w only ever touches workerWorkspaces[w], and each search writes its own result slot
+void WeightedGraphType::shortestPaths(const vector<int>& sources, vector<ShortestPathTree>& results) {
+    results.resize(sources.size());
+    batchPool().parallelFor((int)sources.size(), [&](int worker, int position) {
+        shortestPathTree(sources[position], results[position], workerWorkspaces[worker]);
+    });
+}
+
+
+vector<ShortestPathTree> WeightedGraphType::shortestPaths(const vector<int>& sources) {
+    vector<ShortestPathTree> results;
+    shortestPaths(sources, results);
+    return results;
+}
+
+
+// Function to run one search per source across the worker pool and visit each tree
+// Each worker computes into the tree buffer of its own workspace
+void WeightedGraphType::forEachShortestPathTree(const vector<int>& sources, const function<void(int, const ShortestPathTree&)>& visit) {
+    batchPool().parallelFor((int)sources.size(), [&](int worker, int position) {
+        DijkstraWorkspace& workspace = workerWorkspaces[worker];
+        shortestPathTree(sources[position], workspace.tree, workspace);
+        visit(position, workspace.tree);
+    });
+}
+
+
 // Function to find the shortest path from a given vertex to all other vertices
-// Returns a vector containing the smallest weights from the source vertex
+// Returns a vector containing the smallest weights from the source vertex (DBL_MAX if unreachable)
 vector<double> WeightedGraphType::shortestPath(int index) {
+    return shortestPathTree(index).distance;
+} //end shortestPath
+
+
+// Function to find the shortest path from a given vertex to all other vertices
+// Original dense version: picks the next vertex with a linear scan, O(V^2) per query
+// Returns a vector containing the smallest weights from the source vertex
+vector<double> WeightedGraphType::shortestPathDense(int index) {
     // Vector to store the smallest weights from the source vertex
-    vector<double> smallestWeight(gSize);
+    vector<double> smallestWeight(gSize, DBL_MAX);
     
-    // Initialize the vector with the weights from the source vertex to all other vertices
-    for (int j = 0; j < gSize; j++)
-        smallestWeight[j] = weights[index][j];
+    // Initialize the vector with the weights from the source vertex to its neighbours
+    for (int e = edgeOffsets[index]; e < edgeOffsets[index + 1]; e++)
+        smallestWeight[edgeTargets[e]] = edgeWeights[e];
 
     // Array to keep track of whether the minimum weight to a vertex is found
     bool *weightFound;
@@ -198,88 +1201,295 @@ vector<double> WeightedGraphType::shortestPath(int index) {
         weightFound[v] = true;
 
         // Update the smallest weights to other vertices through the newly found vertex
-        for (int j = 0; j < gSize; j++)
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int j = edgeTargets[e];
             if (!weightFound[j])
-                if (minWeight + weights[v][j] < smallestWeight[j])
-                    smallestWeight[j] = minWeight + weights[v][j];
+                if (minWeight + edgeWeights[e] < smallestWeight[j])
+                    smallestWeight[j] = minWeight + edgeWeights[e];
+        }
     } //end for
+
+    delete[] weightFound;
     
     return smallestWeight;
-} //end shortestPath
+} //end shortestPathDense
 
 
 
 // Function to find the shortest path from a given origin to a destination
-// Returns a stack containing the vertices in the shortest path
+// Returns a stack containing the vertices in the shortest path, with the origin on top
 stack<int> WeightedGraphType::shortestPath(int origin, int destination) {
-    // Vector to store the smallest weights from the origin to all other vertices
-    vector<double> smallestWeight(gSize);
-    
-    // Initialize the vector with the weights from the origin to all other vertices
-    for (int j = 0; j < gSize; j++)
-        smallestWeight[j] = weights[origin][j];
+    vector<int> path;
+    stack<int> pathStack;
 
-    // Array to keep track of whether the minimum weight to a vertex is found
-    bool *weightFound;
-    weightFound = new bool[gSize];
+    if (shortestPath(origin, destination, path) == DBL_MAX) {
+        pathStack.push(destination);
+        return pathStack;
+    }
 
-    // Initialize the array to false, indicating that no weights are found yet
-    for (int j = 0; j < gSize; j++)
-        weightFound[j] = false;
+    for (int k = (int)path.size() - 1; k >= 0; k--)
+        pathStack.push(path[k]);
+    return pathStack;
+} //end shortestPath
 
-    // Set the origin vertex as found with a weight of 0
-    weightFound[origin] = true;
-    smallestWeight[origin] = 0;
 
-    // Loop to find the smallest weights to all vertices
-    for (int i = 0; i < gSize - 1; i++) {
-        double minWeight = DBL_MAX;
-        int v = 0;
+// Function to find the shortest path from a given origin to a destination into a path buffer
+// All the search state lives in the calling thread's workspace, so once its buffers have grown
+// to the graph size (and path to the path length) a query does not allocate
+double WeightedGraphType::shortestPath(int origin, int destination, vector<int>& path) {
+    if (positions.empty())
+        return shortestPathDijkstra(origin, destination, path);
 
-        // Find the vertex with the minimum weight that is not yet found
-        for (int j = 0; j < gSize; j++)
-            if (!weightFound[j])
-                if (smallestWeight[j] < minWeight) {
-                    v = j;
-                    minWeight = smallestWeight[v];
-                }
+    EV_TIMER_LEG("shortestPath A*", origin, destination);
+    return shortestPathGuided(origin, destination, path, [&](int v) {
+        return lowerBoundScale * straightLine(v, destination);
+    });
+} //end shortestPath
 
-        // Mark the vertex as found
-        weightFound[v] = true;
 
-        // Update the smallest weights to other vertices through the newly found vertex
-        for (int j = 0; j < gSize; j++)
-            if (!weightFound[j])
-                if (minWeight + weights[v][j] < smallestWeight[j])
-                    smallestWeight[j] = minWeight + weights[v][j];
-    } //end for
-    
-    // Create a stack to store the path
-    stack<int> pathStack;
+double WeightedGraphType::shortestPathDijkstra(int origin, int destination, vector<int>& path) {
+    EV_TIMER_LEG("shortestPath", origin, destination);
+    return shortestPathGuided(origin, destination, path, [](int) {
+        return 0.0;
+    });
+}
 
-    // Build the path by backtracking from the destination index
-    int current = destination;
-    pathStack.push(current);
 
-    while (current != origin) {
-        bool pathFound = false;
-        for (int j = 0; j < gSize; j++) {
-            if (weights[j][current] < DBL_MAX && smallestWeight[current] == smallestWeight[j] + weights[j][current]) {
-                current = j;
-                pathStack.push(current);
-                pathFound = true;
-                break;
+// Function to search from origin until destination is settled
+// Vertices are taken in order of distance so far plus the lower bound of the distance still to
+// go (A*), so the search settles only the vertices whose bound says they could lie on a shortest
+// path. With a consistent bound a vertex is final when it is taken, as in Dijkstra's algorithm
+// (which is the bound 0). A bound that is only admissible may take a vertex too early; it is then
+// taken again when a shorter path reaches it, so the first time the destination is taken is still right
+template <class LowerBound>
+double WeightedGraphType::shortestPathGuided(int origin, int destination, vector<int>& path, const LowerBound& bound) {
+    SearchCounters counters;
+    DijkstraWorkspace& workspace = queryWorkspace();
+    vector<pair<double, int>>& heap = workspace.heap;
+    greater<pair<double, int>> later;
+    path.clear();
+
+    workspace.newSearch(gSize);
+    workspace.setDistance(origin, 0, -1);
+    heap.push_back(make_pair(bound(origin), origin));
+    counters.pushes++;
+
+    while (!heap.empty()) {
+        pop_heap(heap.begin(), heap.end(), later);
+        double key = heap.back().first;
+        int v = heap.back().second;
+        heap.pop_back();
+        counters.pops++;
+
+        // Skip entries that were superseded by a shorter path
+        double minWeight = workspace.distanceOf(v);
+        if (key > minWeight + bound(v))
+            continue;
+        counters.settled++;
+        workspace.settled++;
+
+        // The destination is settled: follow the predecessors back to the origin
+        if (v == destination) {
+            for (int u = destination; u != -1; u = workspace.predecessorOf(u))
+                path.push_back(u);
+            reverse(path.begin(), path.end());
+            return minWeight;
+        }
+
+        // Relax the edges leaving v
+        counters.relaxed += edgeOffsets[v + 1] - edgeOffsets[v];
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            int j = edgeTargets[e];
+            double weight = minWeight + edgeWeights[e];
+
+            double known = workspace.distanceOf(j);
+            if (weight < known) {
+                workspace.setDistance(j, weight, v);
+                heap.push_back(make_pair(weight + bound(j), j));
+                push_heap(heap.begin(), heap.end(), later);
+                counters.pushes++;
+            } else if (weight == known && v < workspace.predecessorOf(j)) {
+                // Of equally short paths keep the one through the lowest-numbered vertex, so
+                // both searches pick the same path whatever order they settle vertices in
+                workspace.predecessor[j] = v;
             }
         }
-        
-        if (!pathFound) {
+    } //end while
+
+    return DBL_MAX;
+} //end shortestPathGuided
+
+
+// Function to search from both ends until the searches meet
+// Each step settles a vertex on the side whose heap has the smaller top. best is the shortest
+// origin -> destination path seen so far through an edge from a vertex one side has reached to
+// one the other side has reached. Every path still unseen is at least as long as the two heap
+// tops together (top entries may be stale, which only makes them smaller), so once they add up
+// to best nothing shorter is left. Both searches stop at about half the distance, so on a road
+// network they settle about half the vertices of a one-sided search
+double WeightedGraphType::shortestPathBidirectional(int origin, int destination, vector<int>& path) {
+    EV_TIMER_LEG("shortestPath bidirectional", origin, destination);
+    SearchCounters counters;
+    DijkstraWorkspace& forward = queryWorkspace();
+    DijkstraWorkspace& backward = backwardWorkspace();
+    greater<pair<double, int>> later;
+    path.clear();
+
+    forward.newSearch(gSize);
+    backward.newSearch(gSize);
+    forward.setDistance(origin, 0, -1);
+    backward.setDistance(destination, 0, -1);
+    forward.heap.push_back(make_pair(0.0, origin));
+    backward.heap.push_back(make_pair(0.0, destination));
+    counters.pushes += 2;
+
+    double best = origin == destination ? 0 : DBL_MAX;
+    int meeting = origin == destination ? origin : -1;
+
+    while (!forward.heap.empty() && !backward.heap.empty()) {
+        if (forward.heap.front().first + backward.heap.front().first >= best)
             break;
+
+        // Settle the nearer of the two tops; the backward side follows the edges entering v
+        bool isForward = forward.heap.front().first <= backward.heap.front().first;
+        DijkstraWorkspace& side = isForward ? forward : backward;
+        DijkstraWorkspace& other = isForward ? backward : forward;
+
+        pop_heap(side.heap.begin(), side.heap.end(), later);
+        double minWeight = side.heap.back().first;
+        int v = side.heap.back().second;
+        side.heap.pop_back();
+        counters.pops++;
+
+        if (minWeight > side.distanceOf(v))
+            continue;
+        counters.settled++;
+        forward.settled++;
+
+        int begin = isForward ? edgeOffsets[v] : reverseOffsets[v];
+        int end = isForward ? edgeOffsets[v + 1] : reverseOffsets[v + 1];
+        counters.relaxed += end - begin;
+        for (int k = begin; k < end; k++) {
+            int j = isForward ? edgeTargets[k] : reverseSources[k];
+            double weight = minWeight + edgeWeights[isForward ? k : reverseEdges[k]];
+
+            if (weight < side.distanceOf(j)) {
+                side.setDistance(j, weight, v);
+                side.heap.push_back(make_pair(weight, j));
+                push_heap(side.heap.begin(), side.heap.end(), later);
+                counters.pushes++;
+            }
+
+            // A path through this edge joins the two searches
+            double rest = other.distanceOf(j);
+            if (rest < DBL_MAX && weight + rest < best) {
+                best = weight + rest;
+                meeting = j;
+            }
+        }
+    } //end while
+
+    if (meeting == -1)
+        return DBL_MAX;
+
+    // Origin to the meeting vertex by the forward predecessors, then on to the destination by
+    // the backward ones, which point towards it
+    for (int u = meeting; u != -1; u = forward.predecessorOf(u))
+        path.push_back(u);
+    reverse(path.begin(), path.end());
+    for (int u = backward.predecessorOf(meeting); u != -1; u = backward.predecessorOf(u))
+        path.push_back(u);
+    return best;
+} //end shortestPathBidirectional
+
+
+// Function to search the fixed-point weights with a Queue
+// The same search as shortestPathGuided without a bound, on integer distances: stale entries have
+// a larger key than the distance of their vertex, and of equally short paths the one through the
+// lowest-numbered vertex is kept, both by exact comparisons
+template <class Queue>
+void WeightedGraphType::fixedPointSearch(int origin, int destination, FixedPointWorkspace<Queue>& workspace) {
+    SearchCounters counters;
+    Queue& queue = workspace.queue;
+
+    workspace.newSearch(gSize, largestFixedWeight);
+    workspace.setDistance(origin, 0, -1);
+    queue.push(0, origin);
+    counters.pushes++;
+
+    while (!queue.empty()) {
+        uint64_t minWeight;
+        int v = queue.pop(minWeight);
+        counters.pops++;
+
+        if (minWeight > workspace.distance[v])
+            continue;
+        counters.settled++;
+        workspace.settled++;
+        if (v == destination)
+            return;
+
+        counters.relaxed += edgeOffsets[v + 1] - edgeOffsets[v];
+        for (int e = edgeOffsets[v]; e < edgeOffsets[v + 1]; e++) {
+            if (fixedWeights[e] == closedRoad)
+                continue;
+            int j = edgeTargets[e];
+            uint64_t weight = minWeight + fixedWeights[e];
+
+            uint64_t known = workspace.distanceOf(j);
+            if (weight < known) {
+                workspace.setDistance(j, weight, v);
+                queue.push(weight, j);
+                counters.pushes++;
+            } else if (weight == known && v < workspace.predecessor[j]) {
+                workspace.predecessor[j] = v;
+            }
         }
+    } //end while
+} //end fixedPointSearch
+
+
+// Function to find the shortest path tree from a given vertex over the fixed-point weights
+template <class Queue>
+bool WeightedGraphType::shortestPathTreeFixed(int index, ShortestPathTree& tree) {
+    EV_TIMER("shortestPathTreeFixed");
+    if (fixedPointScale == 0)
+        return false;
+    FixedPointWorkspace<Queue>& workspace = fixedPointWorkspace<Queue>();
+    fixedPointSearch(index, -1, workspace);
+
+    tree.source = index;
+    tree.distance.resize(gSize);
+    tree.predecessor.resize(gSize);
+    for (int v = 0; v < gSize; v++) {
+        bool reached = workspace.stamp[v] == workspace.generation;
+        tree.distance[v] = reached ? (double)workspace.distance[v] / fixedPointScale : DBL_MAX;
+        tree.predecessor[v] = reached ? workspace.predecessor[v] : -1;
     }
+    return true;
+} //end shortestPathTreeFixed
 
-    // Return the stack containing the shortest path
-    return pathStack;
-} //end shortestPath
+
+// Function to find the shortest path from origin to destination over the fixed-point weights
+// Returns DBL_MAX with an empty path if the destination is unreachable or useFixedPointWeights is off
+template <class Queue>
+double WeightedGraphType::shortestPathFixed(int origin, int destination, vector<int>& path) {
+    EV_TIMER_LEG("shortestPathFixed", origin, destination);
+    path.clear();
+    if (fixedPointScale == 0)
+        return DBL_MAX;
+    FixedPointWorkspace<Queue>& workspace = fixedPointWorkspace<Queue>();
+    fixedPointSearch(origin, destination, workspace);
+    queryWorkspace().settled = workspace.settled;
+
+    uint64_t weight = workspace.distanceOf(destination);
+    if (weight == UINT64_MAX)
+        return DBL_MAX;
+    for (int u = destination; u != -1; u = workspace.predecessor[u])
+        path.push_back(u);
+    reverse(path.begin(), path.end());
+    return (double)weight / fixedPointScale;
+} //end shortestPathFixed
 
 
 #endif /* WeightedGraph_h */